@@ -0,0 +1,29 @@
+#ifndef CHESS_ENGINE_BENCH_H
+#define CHESS_ENGINE_BENCH_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace chess_engine {
+namespace bench {
+
+constexpr int DEFAULT_BENCH_DEPTH = 5;
+
+// Size of the table every bench search starts from, fixed so that node counts do not
+// depend on the Hash option
+constexpr size_t BENCH_HASH_MB = 16;
+
+// Openings, middlegames and endgames, including positions with mate, stalemate and promotions
+extern const std::vector<std::string> POSITIONS;
+
+// Search the built-in positions to a fixed depth on one thread, each from an empty table,
+// and print per-position and total nodes and the speed. The total node count is a
+// signature of search behavior: a pure speedup must leave it unchanged.
+uint64_t run(int depth, std::ostream &out);
+
+} // namespace bench
+} // namespace chess_engine
+
+#endif
@@ -0,0 +1,344 @@
+#include "../generator/evaluate.h"
+#include "../generator/nnue.h"
+#include "../generator/order.h"
+#include "../generator/transposition.h"
+#include "../generator/zobrist.h"
+#include "../moves/moves.h"
+#include "../structure/game_state.h"
+#include "bench.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace chess_engine;
+
+// Cost of individual hot functions over the bench positions: time and heap allocations per
+// call, and calls per second. Every benchmark repeats its pass over the corpus until the
+// minimum time has elapsed.
+//
+// Usage: chess_bench [--filter <substring>] [--min-time <ms>] [--json <file>] [--tt-mb <size>]
+//                    [--eval-file <network>]
+//
+// The NNUE benchmarks run only when a network is given.
+
+// Every heap allocation of the process goes through here and is counted
+std::atomic<uint64_t> allocations{0};
+
+void *operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+// Keeps results alive so the compiler cannot drop the work that produced them
+volatile uint64_t sink = 0;
+
+struct Position {
+    game_state::GameState state;
+    std::vector<moves::Move> legal_moves;
+    std::vector<moves::Move> captures;
+    std::string fen;
+};
+
+// One pass over the corpus, returning the number of calls made
+using Pass = std::function<uint64_t(std::vector<Position> &)>;
+
+struct Benchmark {
+    std::string name;
+    Pass pass;
+};
+
+struct Measurement {
+    std::string name;
+    uint64_t operations = 0;
+    double ns_per_op = 0;
+    double allocations_per_op = 0;
+    double ops_per_second = 0;
+};
+
+Measurement measure(const Benchmark &benchmark, std::vector<Position> &corpus, double min_time_ms) {
+    // One untimed pass warms caches and lazily built tables
+    benchmark.pass(corpus);
+
+    Measurement result;
+    result.name = benchmark.name;
+
+    uint64_t allocations_before = allocations.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> elapsed{0};
+    while (elapsed.count() < min_time_ms) {
+        result.operations += benchmark.pass(corpus);
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    uint64_t allocated = allocations.load(std::memory_order_relaxed) - allocations_before;
+
+    double operations = static_cast<double>(std::max<uint64_t>(1, result.operations));
+    result.ns_per_op = elapsed.count() * 1e6 / operations;
+    result.allocations_per_op = allocated / operations;
+    result.ops_per_second = operations / (elapsed.count() / 1000.0);
+    return result;
+}
+
+const std::vector<Benchmark> BENCHMARKS = {
+    {"generate_legal_moves", [](std::vector<Position> &corpus) {
+         for (auto &position : corpus) {
+             sink = sink + moves::generate_legal_moves(position.state.turn, position.state).size();
+         }
+         return static_cast<uint64_t>(corpus.size());
+     }},
+    {"generate_legal_captures", [](std::vector<Position> &corpus) {
+         for (auto &position : corpus) {
+             sink = sink + moves::generate_legal_captures(position.state.turn, position.state).size();
+         }
+         return static_cast<uint64_t>(corpus.size());
+     }},
+    // make_move cannot be timed without the unmake_move that restores the position
+    {"make_move+unmake_move", [](std::vector<Position> &corpus) {
+         uint64_t calls = 0;
+         for (auto &position : corpus) {
+             for (const auto &move : position.legal_moves) {
+                 position.state.make_move(move);
+                 position.state.unmake_move();
+             }
+             calls += position.legal_moves.size();
+         }
+         return calls;
+     }},
+    {"compute_hash", [](std::vector<Position> &corpus) {
+         for (auto &position : corpus) {
+             sink = sink + zobrist::compute_hash(position.state);
+         }
+         return static_cast<uint64_t>(corpus.size());
+     }},
+    // The hand-written evaluation, even when a network is loaded
+    {"evaluate_position", [](std::vector<Position> &corpus) {
+         nnue::set_enabled(false);
+         for (auto &position : corpus) {
+             sink = sink + evaluate::evaluate_position(position.state.turn, position.state);
+         }
+         nnue::set_enabled(true);
+         return static_cast<uint64_t>(corpus.size());
+     }},
+    {"see", [](std::vector<Position> &corpus) {
+         uint64_t calls = 0;
+         for (auto &position : corpus) {
+             for (const auto &capture : position.captures) {
+                 sink = sink + evaluate::see(position.state, capture);
+             }
+             calls += position.captures.size();
+         }
+         return calls;
+     }},
+    {"order_moves", [](std::vector<Position> &corpus) {
+         order::Heuristics heuristics;
+         for (auto &position : corpus) {
+             sink = sink + order::order_moves(position.legal_moves, position.state, &heuristics, 0).size();
+         }
+         return static_cast<uint64_t>(corpus.size());
+     }},
+    // FEN parsing (with validation) and serialization, as done per position by the bulk tools
+    {"set_game_state", [](std::vector<Position> &corpus) {
+         for (auto &position : corpus) {
+             sink = sink + game_state::set_game_state(position.fen).halfmove_clock;
+         }
+         return static_cast<uint64_t>(corpus.size());
+     }},
+    {"to_fen", [](std::vector<Position> &corpus) {
+         for (auto &position : corpus) {
+             sink = sink + game_state::to_fen(position.state).size();
+         }
+         return static_cast<uint64_t>(corpus.size());
+     }},
+};
+
+// NNUE evaluation from an up-to-date accumulator (output layer only), after a move (one
+// incremental accumulator update), and from scratch
+const std::vector<Benchmark> NNUE_BENCHMARKS = {
+    {"nnue_evaluate", [](std::vector<Position> &corpus) {
+         for (auto &position : corpus) {
+             sink = sink + nnue::evaluate(position.state.turn, position.state);
+         }
+         return static_cast<uint64_t>(corpus.size());
+     }},
+    {"make_move+nnue_evaluate", [](std::vector<Position> &corpus) {
+         uint64_t calls = 0;
+         for (auto &position : corpus) {
+             for (const auto &move : position.legal_moves) {
+                 position.state.make_move(move);
+                 sink = sink + nnue::evaluate(position.state.turn, position.state);
+                 position.state.unmake_move();
+             }
+             calls += position.legal_moves.size();
+         }
+         return calls;
+     }},
+    {"nnue_refresh", [](std::vector<Position> &corpus) {
+         nnue::Accumulator accumulator;
+         for (auto &position : corpus) {
+             nnue::refresh(accumulator, position.state.board);
+             sink = sink + accumulator.values[0][0];
+         }
+         return static_cast<uint64_t>(corpus.size());
+     }},
+};
+
+// Random keys probed one after another, each probe's address depending on the previous result,
+// so the time per probe is the full memory latency of a table slot rather than its throughput
+constexpr size_t PROBE_KEYS = 1 << 20;
+
+Benchmark tt_probe_benchmark(transposition::PageMode pages, size_t size_mb) {
+    std::string name = std::string("tt_probe/") + transposition::page_mode_name(pages);
+    auto table = std::make_shared<std::unique_ptr<transposition::TranspositionTable>>();
+    auto keys = std::make_shared<std::vector<uint64_t>>();
+
+    return {name, [name, table, keys, pages, size_mb](std::vector<Position> &) {
+                // Built on the first (untimed) pass, and filled so that every probe hits
+                if (!*table) {
+                    *table = std::make_unique<transposition::TranspositionTable>(size_mb, pages);
+                    if ((*table)->page_mode() != pages) {
+                        std::printf("(%s fell back to %s pages)\n", name.c_str(), transposition::page_mode_name((*table)->page_mode()));
+                    }
+                    std::mt19937_64 gen(1);
+                    keys->resize(PROBE_KEYS);
+                    for (auto &key : *keys) {
+                        key = gen();
+                        (*table)->store(key, 1, 0, transposition::NodeType::EXACT, moves::Move());
+                    }
+                }
+
+                size_t index = 0;
+                for (size_t i = 0; i < PROBE_KEYS; ++i) {
+                    int score = 0;
+                    transposition::NodeType type;
+                    moves::Move move;
+                    (*table)->probe((*keys)[index], 0, score, type, move);
+                    index = (index + 1 + static_cast<size_t>(score)) & (PROBE_KEYS - 1);
+                }
+                sink = sink + index;
+                return static_cast<uint64_t>(PROBE_KEYS);
+            }};
+}
+
+std::string json_escape(const std::string &text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool write_json(const std::string &path, const std::vector<Measurement> &results, size_t positions, double min_time_ms) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << "{\n";
+    out << "  \"context\": {\"date\": \"" << date << "\", \"positions\": " << positions << ", \"min_time_ms\": " << min_time_ms << "},\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Measurement &result = results[i];
+        out << "    {\"name\": \"" << json_escape(result.name) << "\", \"operations\": " << result.operations
+            << ", \"ns_per_op\": " << result.ns_per_op << ", \"allocations_per_op\": " << result.allocations_per_op
+            << ", \"ops_per_second\": " << result.ops_per_second << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return true;
+}
+
+int main(int argc, char **argv) {
+    zobrist::init_zobrist_keys();
+
+    std::string filter, json_path;
+    double min_time_ms = 500;
+    size_t tt_mb = 1024;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--filter") {
+            filter = argv[i + 1];
+        } else if (arg == "--min-time") {
+            min_time_ms = std::atof(argv[i + 1]);
+        } else if (arg == "--json") {
+            json_path = argv[i + 1];
+        } else if (arg == "--tt-mb") {
+            tt_mb = std::max(1, std::atoi(argv[i + 1]));
+        } else if (arg == "--eval-file") {
+            if (!nnue::load(argv[i + 1])) {
+                std::fprintf(stderr, "cannot load NNUE network %s\n", argv[i + 1]);
+                return 1;
+            }
+        } else {
+            std::fprintf(stderr, "unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::vector<Position> corpus;
+    for (const auto &fen : bench::POSITIONS) {
+        Position position{game_state::set_game_state(fen), {}, {}, fen};
+        position.legal_moves = moves::generate_legal_moves(position.state.turn, position.state);
+        position.captures = moves::generate_legal_captures(position.state.turn, position.state);
+        corpus.push_back(position);
+    }
+
+    std::printf("%zu positions, at least %.0f ms per benchmark\n", corpus.size(), min_time_ms);
+    std::printf("%-24s %14s %12s %12s %14s\n", "benchmark", "calls", "ns/op", "allocs/op", "ops/s");
+
+    // One probe benchmark per page mode. A mode the system cannot provide falls back to the next
+    // one down, which is reported.
+    std::vector<Benchmark> benchmarks = BENCHMARKS;
+    if (nnue::is_loaded()) {
+        std::printf("NNUE inference: %s\n", nnue::simd_name());
+        benchmarks.insert(benchmarks.end(), NNUE_BENCHMARKS.begin(), NNUE_BENCHMARKS.end());
+    }
+    for (auto pages : {transposition::PageMode::NORMAL, transposition::PageMode::TRANSPARENT, transposition::PageMode::HUGETLB}) {
+        benchmarks.push_back(tt_probe_benchmark(pages, tt_mb));
+    }
+
+    std::vector<Measurement> results;
+    for (auto &benchmark : benchmarks) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        Measurement result = measure(benchmark, corpus, min_time_ms);
+        benchmark.pass = nullptr; // Frees a probed table before the next one is allocated
+        std::printf("%-24s %14llu %12.1f %12.2f %14.0f\n", result.name.c_str(), static_cast<unsigned long long>(result.operations),
+                    result.ns_per_op, result.allocations_per_op, result.ops_per_second);
+        results.push_back(result);
+    }
+
+    if (!json_path.empty() && !write_json(json_path, results, corpus.size(), min_time_ms)) {
+        std::fprintf(stderr, "cannot write %s\n", json_path.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "../generator/search.h"
+#include "../generator/zobrist.h"
+#include "../structure/game_state.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace chess_engine;
+
+// Overhead of MultiPV over a single-PV search of the same positions to the same depth.
+// Usage: chess_multipv_bench [depth]
+
+const std::vector<std::string> POSITIONS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "rn1q1rk1/pbppbppp/1p2pn2/8/2PP4/2N2NP1/PPQ1PPBP/R1B1K2R b KQ - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+const std::vector<int> MULTIPV_COUNTS = {1, 3, 5};
+
+int main(int argc, char **argv) {
+    zobrist::init_zobrist_keys();
+
+    int depth = (argc > 1) ? std::atoi(argv[1]) : search::DEFAULT_DEPTH;
+
+    uint64_t baseline_nodes = 0;
+    double baseline_ms = 0;
+
+    std::printf("depth %d, %zu positions\n", depth, POSITIONS.size());
+    std::printf("%8s %12s %10s %10s %10s\n", "multipv", "nodes", "ms", "nodes x", "time x");
+
+    for (int multipv : MULTIPV_COUNTS) {
+        search::SearchLimits limits;
+        limits.depth = depth;
+        limits.multipv = multipv;
+
+        uint64_t nodes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &fen : POSITIONS) {
+            // Every run starts cold so that no mode profits from another's table
+            search::tt.clear();
+
+            game_state::GameState state = game_state::set_game_state(fen);
+            uint64_t position_nodes = 0;
+            search::find_best_move(limits, state.turn, state, [&position_nodes](const search::SearchInfo &info) {
+                position_nodes = info.nodes;
+            });
+            nodes += position_nodes;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (multipv == 1) {
+            baseline_nodes = nodes;
+            baseline_ms = elapsed.count();
+        }
+
+        std::printf("%8d %12llu %10.0f %10.2f %10.2f\n", multipv, static_cast<unsigned long long>(nodes), elapsed.count(),
+                    static_cast<double>(nodes) / std::max<uint64_t>(1, baseline_nodes), elapsed.count() / std::max(1.0, baseline_ms));
+    }
+
+    return 0;
+}
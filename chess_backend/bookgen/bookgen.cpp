@@ -0,0 +1,407 @@
+#include "bookgen.h"
+#include "../generator/zobrist.h"
+#include "../moves/moves.h"
+#include "../structure/game_state.h"
+#include "../utils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+namespace chess_engine {
+namespace bookgen {
+
+// Results of a move, from the point of view of the side that played it
+struct MoveStats {
+    uint32_t wins = 0;
+    uint32_t draws = 0;
+    uint32_t losses = 0;
+};
+
+struct PositionMove {
+    uint64_t key;
+    uint16_t move;
+
+    bool operator==(const PositionMove &other) const {
+        return key == other.key && move == other.move;
+    }
+};
+
+struct PositionMoveHash {
+    size_t operator()(const PositionMove &position_move) const {
+        return position_move.key ^ (static_cast<uint64_t>(position_move.move) * 0x9E3779B97F4A7C15ULL);
+    }
+};
+
+enum class Outcome {
+    WIN,
+    DRAW,
+    LOSS
+};
+
+// One move of a game, waiting to be merged into the shared statistics
+struct Record {
+    PositionMove position_move;
+    Outcome outcome;
+};
+
+// Statistics split by key into independently locked maps, so workers rarely wait on each other
+constexpr int SHARD_BITS = 6;
+constexpr int SHARD_COUNT = 1 << SHARD_BITS;
+
+// Records a worker buffers per shard before taking the shard's lock
+constexpr size_t FLUSH_SIZE = 4096;
+
+struct Shard {
+    std::mutex mutex;
+    std::unordered_map<PositionMove, MoveStats, PositionMoveHash> stats;
+};
+
+int shard_of(uint64_t key) {
+    return static_cast<int>(key >> (64 - SHARD_BITS));
+}
+
+void merge(Shard &shard, std::vector<Record> &records) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (const auto &record : records) {
+        MoveStats &stats = shard.stats[record.position_move];
+        if (record.outcome == Outcome::WIN) {
+            ++stats.wins;
+        } else if (record.outcome == Outcome::DRAW) {
+            ++stats.draws;
+        } else {
+            ++stats.losses;
+        }
+    }
+    records.clear();
+}
+
+// Start of the first game at or after offset: a line beginning with "[Event "
+size_t game_start_at_or_after(const utils::MappedFile &file, size_t offset) {
+    static const char tag[] = "[Event ";
+    const size_t tag_length = sizeof(tag) - 1;
+    const char *data = file.data();
+    size_t size = file.size();
+
+    for (size_t i = offset; i + tag_length <= size; ++i) {
+        if ((i == 0 || data[i - 1] == '\n') && std::memcmp(data + i, tag, tag_length) == 0) {
+            return i;
+        }
+        // Skip to the next line
+        const void *newline = std::memchr(data + i, '\n', size - i);
+        if (newline == nullptr) {
+            break;
+        }
+        i = static_cast<const char *>(newline) - data;
+    }
+    return size;
+}
+
+// Chunk boundaries are found independently by the two workers sharing them, so every game
+// lands in exactly one chunk
+size_t chunk_boundary(const utils::MappedFile &file, size_t chunk, size_t chunk_bytes) {
+    if (chunk == 0) {
+        return 0;
+    }
+    return game_start_at_or_after(file, std::min(file.size(), chunk * chunk_bytes));
+}
+
+std::string tag_value(const char *line, const char *end) {
+    const char *open = static_cast<const char *>(std::memchr(line, '"', end - line));
+    if (open == nullptr) {
+        return "";
+    }
+    const char *close = static_cast<const char *>(std::memchr(open + 1, '"', end - open - 1));
+    return close == nullptr ? "" : std::string(open + 1, close);
+}
+
+// Replays the moves of a game and appends them to records, reading only as far as the book goes
+bool replay_movetext(const char *p, const char *end, game_state::GameState &state, Outcome white_outcome, int max_ply,
+                     std::vector<Record> &records, uint64_t &plies) {
+    int ply = 0;
+    int variation_depth = 0;
+    std::string token;
+    while (p < end && ply < max_ply) {
+        char c = *p;
+        if (c == '{') {
+            const char *close = static_cast<const char *>(std::memchr(p, '}', end - p));
+            p = (close == nullptr) ? end : close + 1;
+            continue;
+        }
+        if (c == ';') {
+            const char *newline = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            p = (newline == nullptr) ? end : newline + 1;
+            continue;
+        }
+        if (c == '(') {
+            ++variation_depth;
+            ++p;
+            continue;
+        }
+        if (c == ')') {
+            variation_depth = std::max(0, variation_depth - 1);
+            ++p;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            ++p;
+            continue;
+        }
+
+        const char *token_end = p;
+        while (token_end < end && !std::strchr(" \t\r\n{}();", *token_end)) {
+            ++token_end;
+        }
+        token.assign(p, token_end);
+        p = token_end;
+
+        if (variation_depth > 0 || token[0] == '$') {
+            continue;
+        }
+        if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+            break;
+        }
+
+        // Move numbers, possibly glued to the move: "12.", "12...", "12.e4"
+        size_t dot = token.find_last_of('.');
+        if (dot != std::string::npos) {
+            token.erase(0, dot + 1);
+            if (token.empty()) {
+                continue;
+            }
+        }
+
+        moves::Move move = moves::from_san(token, state);
+        if (move.is_null()) {
+            return ply > 0; // Keep the moves read so far
+        }
+
+        bool white_moved = state.turn == piece::Color::WHITE;
+        Outcome outcome = white_outcome;
+        if (!white_moved && white_outcome != Outcome::DRAW) {
+            outcome = (white_outcome == Outcome::WIN) ? Outcome::LOSS : Outcome::WIN;
+        }
+        records.push_back({{zobrist::polyglot_hash(state), book::encode_move(move)}, outcome});
+
+        state.make_move(move);
+        ++ply;
+        ++plies;
+    }
+    return true;
+}
+
+
+// Replays one game's text and appends its book moves. Returns false for games that cannot be used.
+bool replay_game(const char *begin, const char *end, int max_ply, std::vector<Record> &records, uint64_t &plies) {
+    std::string result, fen = utils::START_FEN;
+    bool standard = true;
+
+    // Tag pairs
+    const char *p = begin;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+            ++p;
+        }
+        if (p >= end || *p != '[') {
+            break;
+        }
+        const char *line_end = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        line_end = (line_end == nullptr) ? end : line_end;
+        if (std::strncmp(p, "[Result ", 8) == 0) {
+            result = tag_value(p, line_end);
+        } else if (std::strncmp(p, "[FEN ", 5) == 0) {
+            fen = tag_value(p, line_end);
+        } else if (std::strncmp(p, "[Variant ", 9) == 0) {
+            std::string variant = tag_value(p, line_end);
+            standard = variant.empty() || variant == "Standard" || variant == "standard";
+        }
+        p = line_end;
+    }
+
+    Outcome white_outcome;
+    if (result == "1-0") {
+        white_outcome = Outcome::WIN;
+    } else if (result == "0-1") {
+        white_outcome = Outcome::LOSS;
+    } else if (result == "1/2-1/2") {
+        white_outcome = Outcome::DRAW;
+    } else {
+        return false;
+    }
+    if (!standard) {
+        return false;
+    }
+
+    try {
+        game_state::GameState state = game_state::set_game_state(fen);
+        return replay_movetext(p, end, state, white_outcome, max_ply, records, plies);
+    } catch (const std::exception &e) {
+        return false; // Unreadable FEN
+    }
+}
+
+// Polyglot's weight: a win counts twice as much as a draw
+uint64_t weight_of(const MoveStats &stats) {
+    return 2ULL * stats.wins + stats.draws;
+}
+
+std::vector<book::Entry> build(const std::vector<std::string> &pgn_paths, const Options &options, Progress &progress,
+                               const std::function<void(const Progress &)> &on_progress) {
+    std::vector<Shard> shards(SHARD_COUNT);
+    std::atomic<uint64_t> games{0}, skipped{0}, plies{0}, bytes{0};
+    auto start = std::chrono::steady_clock::now();
+
+    auto snapshot = [&]() {
+        Progress current;
+        current.games = games.load(std::memory_order_relaxed);
+        current.skipped = skipped.load(std::memory_order_relaxed);
+        current.plies = plies.load(std::memory_order_relaxed);
+        current.bytes = bytes.load(std::memory_order_relaxed);
+        current.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return current;
+    };
+
+    size_t chunk_bytes = std::max<size_t>(1, options.chunk_bytes);
+    for (const auto &path : pgn_paths) {
+        utils::MappedFile file(path);
+        size_t chunk_count = (file.size() + chunk_bytes - 1) / chunk_bytes;
+        std::atomic<size_t> next_chunk{0};
+
+        std::mutex done_mutex;
+        std::condition_variable done_changed;
+        int finished = 0;
+
+        auto worker = [&]() {
+            std::vector<std::vector<Record>> buffers(SHARD_COUNT);
+            std::vector<Record> game_records;
+            uint64_t game_plies = 0;
+
+            for (size_t chunk = next_chunk.fetch_add(1); chunk < chunk_count; chunk = next_chunk.fetch_add(1)) {
+                size_t chunk_begin = chunk_boundary(file, chunk, chunk_bytes);
+                size_t chunk_end = chunk_boundary(file, chunk + 1, chunk_bytes);
+
+                size_t game_begin = game_start_at_or_after(file, chunk_begin);
+                while (game_begin < chunk_end) {
+                    size_t game_end = std::min(chunk_end, game_start_at_or_after(file, game_begin + 1));
+
+                    game_records.clear();
+                    game_plies = 0;
+                    if (replay_game(file.data() + game_begin, file.data() + game_end, options.max_ply, game_records, game_plies)) {
+                        games.fetch_add(1, std::memory_order_relaxed);
+                        plies.fetch_add(game_plies, std::memory_order_relaxed);
+                        for (const auto &record : game_records) {
+                            std::vector<Record> &buffer = buffers[shard_of(record.position_move.key)];
+                            buffer.push_back(record);
+                            if (buffer.size() >= FLUSH_SIZE) {
+                                merge(shards[shard_of(record.position_move.key)], buffer);
+                            }
+                        }
+                    } else {
+                        skipped.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    game_begin = game_end;
+                }
+                bytes.fetch_add(chunk_end - chunk_begin, std::memory_order_relaxed);
+            }
+
+            for (int shard = 0; shard < SHARD_COUNT; ++shard) {
+                if (!buffers[shard].empty()) {
+                    merge(shards[shard], buffers[shard]);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(done_mutex);
+            ++finished;
+            done_changed.notify_all();
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < std::max(1, options.threads); ++i) {
+            workers.emplace_back(worker);
+        }
+
+        // Report while the workers run
+        {
+            std::unique_lock<std::mutex> lock(done_mutex);
+            while (!done_changed.wait_for(lock, std::chrono::seconds(1), [&]() { return finished == static_cast<int>(workers.size()); })) {
+                if (on_progress) {
+                    on_progress(snapshot());
+                }
+            }
+        }
+        for (auto &thread : workers) {
+            thread.join();
+        }
+    }
+
+    // Gather, sort and weigh
+    std::vector<std::pair<PositionMove, MoveStats>> moves;
+    for (auto &shard : shards) {
+        for (const auto &entry : shard.stats) {
+            const MoveStats &stats = entry.second;
+            if (stats.wins + stats.draws + stats.losses >= static_cast<uint32_t>(options.min_count) && weight_of(stats) > 0) {
+                moves.push_back(entry);
+            }
+        }
+        shard.stats.clear();
+    }
+    std::sort(moves.begin(), moves.end(), [](const auto &a, const auto &b) {
+        if (a.first.key != b.first.key) {
+            return a.first.key < b.first.key;
+        }
+        return weight_of(a.second) > weight_of(b.second);
+    });
+
+    std::vector<book::Entry> entries;
+    entries.reserve(moves.size());
+    for (size_t first = 0; first < moves.size();) {
+        // The position's best move (sorted first) sets the scale
+        size_t last = first;
+        while (last < moves.size() && moves[last].first.key == moves[first].first.key) {
+            ++last;
+        }
+        uint64_t max_weight = weight_of(moves[first].second);
+        for (size_t i = first; i < last; ++i) {
+            uint64_t weight = weight_of(moves[i].second);
+            if (max_weight > UINT16_MAX) {
+                weight = std::max<uint64_t>(1, weight * UINT16_MAX / max_weight);
+            }
+            entries.push_back({moves[i].first.key, moves[i].first.move, static_cast<uint16_t>(weight), 0});
+        }
+        first = last;
+    }
+
+    progress = snapshot();
+    return entries;
+}
+
+void write_book(const std::string &path, const std::vector<book::Entry> &entries) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("cannot write " + path);
+    }
+
+    auto put = [&out](uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; --i) {
+            out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    };
+    for (const auto &entry : entries) {
+        put(entry.key, 8);
+        put(entry.move, 2);
+        put(entry.weight, 2);
+        put(entry.learn, 4);
+    }
+    if (!out) {
+        throw std::runtime_error("cannot write " + path);
+    }
+}
+
+} // namespace bookgen
+} // namespace chess_engine
@@ -0,0 +1,43 @@
+#ifndef CHESS_ENGINE_BOOKGEN_H
+#define CHESS_ENGINE_BOOKGEN_H
+
+#include "../generator/book.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chess_engine {
+namespace bookgen {
+
+struct Options {
+    int max_ply = book::DEFAULT_MAX_PLY; // Plies of each game that go into the book
+    int min_count = 1;                   // Moves played fewer times in a position are left out
+    int threads = 1;
+    size_t chunk_bytes = 4 << 20; // PGN text handed to a worker at a time
+};
+
+// Totals of a build, so far or in the end
+struct Progress {
+    uint64_t games = 0;   // Games replayed into the book
+    uint64_t skipped = 0; // Games without a result, from another variant or with an unreadable move
+    uint64_t plies = 0;
+    uint64_t bytes = 0; // PGN text processed
+    double seconds = 0;
+};
+
+// Stream the PGN files through the worker threads and return the book entries, sorted by key
+// and, within a position, by weight. Weights are Polyglot's 2 * wins + draws for the side to
+// move, scaled down per position to fit 16 bits. on_progress is called about once a second from
+// the calling thread; progress receives the final totals.
+std::vector<book::Entry> build(const std::vector<std::string> &pgn_paths, const Options &options, Progress &progress,
+                               const std::function<void(const Progress &)> &on_progress = nullptr);
+
+// Write entries in the Polyglot .bin format
+void write_book(const std::string &path, const std::vector<book::Entry> &entries);
+
+} // namespace bookgen
+} // namespace chess_engine
+
+#endif
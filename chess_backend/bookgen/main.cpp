@@ -0,0 +1,80 @@
+#include "../generator/zobrist.h"
+#include "bookgen.h"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chess_engine;
+
+// Builds a Polyglot opening book from PGN archives, replaying the games on all cores.
+//
+// Usage: chess_bookgen [options] <file.pgn>...
+//   --out <file>        Book to write (default book.bin)
+//   --max-ply <n>       Plies of each game to include (default 20)
+//   --min-count <n>     Leave out moves played fewer times in a position (default 1)
+//   --threads <n>       Worker threads (default: one per hardware thread)
+
+void print_progress(const bookgen::Progress &progress, const char *prefix) {
+    double seconds = std::max(progress.seconds, 1e-9);
+    std::printf("%s%llu games (%llu skipped), %.0f games/s, %.1f MB/s\n", prefix,
+                static_cast<unsigned long long>(progress.games), static_cast<unsigned long long>(progress.skipped),
+                progress.games / seconds, progress.bytes / seconds / (1 << 20));
+    std::fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    zobrist::init_zobrist_keys();
+
+    bookgen::Options options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string out_path = "book.bin";
+    std::vector<std::string> pgn_paths;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) != 0) {
+                pgn_paths.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            std::string value = argv[++i];
+
+            if (arg == "--out") {
+                out_path = value;
+            } else if (arg == "--max-ply") {
+                options.max_ply = std::stoi(value);
+            } else if (arg == "--min-count") {
+                options.min_count = std::max(1, std::stoi(value));
+            } else if (arg == "--threads") {
+                options.threads = std::max(1, std::stoi(value));
+            } else {
+                throw std::invalid_argument("unknown argument: " + arg);
+            }
+        }
+        if (pgn_paths.empty()) {
+            throw std::invalid_argument("no PGN files given");
+        }
+
+        bookgen::Progress progress;
+        std::vector<book::Entry> entries = bookgen::build(pgn_paths, options, progress, [](const bookgen::Progress &current) {
+            print_progress(current, "");
+        });
+        bookgen::write_book(out_path, entries);
+
+        print_progress(progress, "done: ");
+        std::printf("%llu plies, %zu book entries written to %s\n", static_cast<unsigned long long>(progress.plies),
+                    entries.size(), out_path.c_str());
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "chess_bookgen: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "datagen.h"
+#include "../generator/evaluate.h"
+#include "../generator/transposition.h"
+#include "../generator/zobrist.h"
+#include "../moves/moves.h"
+#include "../selfplay/selfplay.h"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace chess_engine {
+namespace datagen {
+
+PackedPosition pack(const game_state::GameState &state, int score, int result) {
+    const board::Board &board = state.get_board();
+    PackedPosition position{};
+    position.occupancy = board.get_white_pieces() | board.get_black_pieces();
+
+    int index = 0;
+    for (bit::Bitboard occupied = position.occupancy; occupied != 0 && index < 32; occupied &= occupied - 1, ++index) {
+        int square = __builtin_ctzll(occupied);
+        int black = (board.get_piece_color(square) == piece::Color::BLACK) ? 1 : 0;
+        int code = (black << 3) | board.get_piece_type(square);
+        position.pieces[index / 2] |= static_cast<uint8_t>(code << (4 * (index % 2)));
+    }
+
+    position.score = static_cast<int16_t>(std::max(-MAX_RECORD_SCORE, std::min(score, MAX_RECORD_SCORE)));
+    position.result = static_cast<uint8_t>(result);
+    position.flags = (state.turn == piece::Color::BLACK ? BLACK_TO_MOVE : 0) |
+                     (state.white_castle_kingside ? WHITE_KINGSIDE : 0) | (state.white_castle_queenside ? WHITE_QUEENSIDE : 0) |
+                     (state.black_castle_kingside ? BLACK_KINGSIDE : 0) | (state.black_castle_queenside ? BLACK_QUEENSIDE : 0);
+    position.en_passant = (state.en_passant_square < 0) ? NO_SQUARE : static_cast<uint8_t>(state.en_passant_square);
+    position.halfmove_clock = static_cast<uint8_t>(std::min(state.halfmove_clock, 255));
+    position.fullmove_number = static_cast<uint16_t>(std::min(state.fullmove_number, 65535));
+    return position;
+}
+
+board::Board unpack_board(const PackedPosition &position) {
+    bit::Bitboard pieces[2][6] = {};
+    int index = 0;
+    for (bit::Bitboard occupied = position.occupancy; occupied != 0 && index < 32; occupied &= occupied - 1, ++index) {
+        int code = (position.pieces[index / 2] >> (4 * (index % 2))) & 15;
+        if ((code & 7) <= piece::Type::KING) {
+            pieces[code >> 3][code & 7] |= occupied & (~occupied + 1);
+        }
+    }
+    return board::Board(pieces[0][piece::PAWN], pieces[0][piece::BISHOP], pieces[0][piece::KNIGHT], pieces[0][piece::ROOK],
+                        pieces[0][piece::QUEEN], pieces[0][piece::KING], pieces[1][piece::PAWN], pieces[1][piece::BISHOP],
+                        pieces[1][piece::KNIGHT], pieces[1][piece::ROOK], pieces[1][piece::QUEEN], pieces[1][piece::KING]);
+}
+
+game_state::GameState unpack(const PackedPosition &position) {
+    return game_state::GameState(unpack_board(position), (position.flags & BLACK_TO_MOVE) ? piece::Color::BLACK : piece::Color::WHITE,
+                                 (position.flags & WHITE_KINGSIDE) != 0, (position.flags & WHITE_QUEENSIDE) != 0,
+                                 (position.flags & BLACK_KINGSIDE) != 0, (position.flags & BLACK_QUEENSIDE) != 0,
+                                 (position.en_passant == NO_SQUARE) ? -1 : position.en_passant, position.halfmove_clock,
+                                 position.fullmove_number);
+}
+
+Writer::Writer(const std::string &path) : path(path), file(path, std::ios::binary | std::ios::app) {
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+}
+
+void Writer::write(const PackedPosition *positions, size_t count) {
+    file.write(reinterpret_cast<const char *>(positions), count * sizeof(PackedPosition));
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("cannot write " + path);
+    }
+}
+
+Shard::Shard(const std::string &path) : file(path) {
+    count = file.size() / sizeof(PackedPosition);
+    records = reinterpret_cast<const PackedPosition *>(file.data());
+}
+
+// splitmix64, to derive independent generators from the seed and the game number
+uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+bool is_quiet(const moves::Move &move, const game_state::GameState &state) {
+    return move.move_type != moves::CAPTURE && move.move_type != moves::EN_PASSANT && move.move_type != moves::PROMOTION &&
+           state.get_board().get_piece_type(move.to) == piece::Type::EMPTY;
+}
+
+// Play game number index with the worker's table, filling in its records and White's result.
+// False if the opening ended the game or left it too one-sided.
+bool play_game(const Options &options, uint64_t index, transposition::TranspositionTable &table,
+               std::vector<PackedPosition> &positions, int &result) {
+    std::mt19937_64 random(mix(options.seed ^ mix(index)));
+    const std::string &fen = options.openings.empty() ? utils::START_FEN : options.openings[random() % options.openings.size()];
+    game_state::GameState state = game_state::set_game_state(fen);
+
+    table.clear();
+    search::SearchState search_state;
+    search_state.table = &table;
+
+    positions.clear();
+    result = 1;
+
+    int random_plies = options.random_plies + static_cast<int>(random() % 2);
+    for (int ply = 0; ply < random_plies; ++ply) {
+        std::vector<moves::Move> legal_moves = moves::generate_legal_moves(state.turn, state);
+        if (legal_moves.empty()) {
+            return false;
+        }
+        search_state.push_position(state);
+        state.make_move(legal_moves[random() % legal_moves.size()]);
+    }
+
+    for (int ply = 0;; ++ply) {
+        piece::Color side = state.turn;
+        std::vector<moves::Move> legal_moves = moves::generate_legal_moves(side, state);
+        if (legal_moves.empty()) {
+            if (ply == 0) {
+                return false;
+            }
+            if (state.is_in_check(side)) {
+                result = (side == piece::Color::WHITE) ? 0 : 2;
+            }
+            break;
+        }
+        if (state.is_draw_by_fifty_move_rule() ||
+            selfplay::repetitions(search_state.key_history, zobrist::compute_hash(state), state.halfmove_clock) >= 2 ||
+            selfplay::insufficient_material(state.get_board()) || ply >= options.max_plies) {
+            break;
+        }
+
+        int score = 0;
+        moves::Move move = search::find_best_move(options.limits, side, state, [&](const search::SearchInfo &info) {
+            if (info.multipv == 1) {
+                score = info.score;
+            }
+        }, nullptr, &search_state);
+
+        if (ply == 0 && std::abs(score) > options.max_opening_score) {
+            return false;
+        }
+
+        bool decided = std::abs(score) >= evaluate::TB_WIN_SCORE - evaluate::MAX_MATE_PLY;
+        if (!decided && !state.is_in_check(side) && is_quiet(move, state)) {
+            positions.push_back(pack(state, (side == piece::Color::WHITE) ? score : -score));
+        }
+
+        search_state.push_position(state);
+        state.make_move(move);
+    }
+
+    for (auto &position : positions) {
+        position.result = static_cast<uint8_t>(result);
+    }
+    return true;
+}
+
+Progress generate(const Options &options, const std::function<void(const Progress &)> &on_game, const std::atomic<bool> *stop) {
+    Writer writer(options.path);
+    Progress progress;
+    std::mutex progress_mutex;
+    std::atomic<uint64_t> next_game{0};
+    std::atomic<bool> finished{false};
+
+    auto worker = [&]() {
+        transposition::TranspositionTable table(options.hash_mb);
+        std::vector<PackedPosition> positions;
+        int result = 1;
+        while (!finished.load(std::memory_order_relaxed) && !(stop != nullptr && stop->load(std::memory_order_relaxed))) {
+            if (!play_game(options, next_game.fetch_add(1), table, positions, result)) {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(progress_mutex);
+
+            // Games still running when the run finished are not written
+            if (finished.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            writer.write(positions.data(), positions.size());
+            ++progress.games;
+            progress.positions += positions.size();
+            ++(result == 2 ? progress.white_wins : result == 0 ? progress.black_wins : progress.draws);
+
+            if ((options.games != 0 && progress.games >= options.games) ||
+                (options.positions != 0 && progress.positions >= options.positions)) {
+                finished.store(true, std::memory_order_relaxed);
+            }
+            if (on_game) {
+                on_game(progress);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::max(1, options.concurrency); ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    return progress;
+}
+
+} // namespace datagen
+} // namespace chess_engine
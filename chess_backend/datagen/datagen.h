@@ -0,0 +1,126 @@
+#ifndef CHESS_ENGINE_DATAGEN_H
+#define CHESS_ENGINE_DATAGEN_H
+
+#include "../generator/search.h"
+#include "../structure/board.h"
+#include "../structure/game_state.h"
+#include "../utils.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chess_engine {
+namespace datagen {
+
+// One scored position of a self-play game in 32 bytes. A data file is nothing but a sequence
+// of these in little-endian byte order, without a header, so shards can be appended to while
+// being read and concatenated with cat.
+struct PackedPosition {
+    uint64_t occupancy; // Occupied squares, a1 = bit 0
+    uint8_t pieces[16]; // A nibble per occupied square, from a1 up, low nibble first: (black << 3) | type
+    int16_t score;      // Search score from White's side, in centipawns
+    uint8_t result;     // White's result in half points: 0, 1 or 2
+    uint8_t flags;      // Bit 0: Black to move; bits 1 to 4: castling rights K, Q, k, q
+    uint8_t en_passant; // Target square, or NO_SQUARE
+    uint8_t halfmove_clock;
+    uint16_t fullmove_number;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "records must stay 32 bytes");
+
+constexpr uint8_t NO_SQUARE = 64;
+constexpr uint8_t BLACK_TO_MOVE = 1;
+constexpr uint8_t WHITE_KINGSIDE = 2;
+constexpr uint8_t WHITE_QUEENSIDE = 4;
+constexpr uint8_t BLACK_KINGSIDE = 8;
+constexpr uint8_t BLACK_QUEENSIDE = 16;
+
+// Scores are clamped to what a record holds; mates and tablebase wins are never recorded
+constexpr int MAX_RECORD_SCORE = 32000;
+
+// White's score is given; the result is filled in when the game ends
+PackedPosition pack(const game_state::GameState &state, int score, int result = 1);
+board::Board unpack_board(const PackedPosition &position);
+game_state::GameState unpack(const PackedPosition &position);
+
+// Appends whole records to a data file, creating it if needed
+class Writer {
+  public:
+    explicit Writer(const std::string &path);
+
+    // Throws if the records could not be written
+    void write(const PackedPosition *positions, size_t count);
+
+  private:
+    std::string path;
+    std::ofstream file;
+};
+
+// A data file mapped read-only; records are read in place, without parsing. A partial record
+// at the end (from a writer still running or interrupted) is ignored.
+class Shard {
+  public:
+    explicit Shard(const std::string &path);
+
+    Shard(const Shard &) = delete;
+    Shard &operator=(const Shard &) = delete;
+
+    size_t size() const {
+        return count;
+    }
+
+    const PackedPosition &operator[](size_t index) const {
+        return records[index];
+    }
+
+    const PackedPosition *begin() const {
+        return records;
+    }
+
+    const PackedPosition *end() const {
+        return records + count;
+    }
+
+  private:
+    utils::MappedFile file;
+    const PackedPosition *records = nullptr;
+    size_t count = 0;
+};
+
+struct Options {
+    search::SearchLimits limits; // Of every move; fixed nodes keep games fast and reproducible
+    size_t hash_mb = 16;         // Private table per worker, cleared between games
+    int concurrency = 1;
+    uint64_t games = 0;     // Stop after this many games; 0 for no limit
+    uint64_t positions = 0; // Stop once this many positions are written; 0 for no limit
+    std::vector<std::string> openings; // Starting FENs, picked at random; empty for the initial position
+    int random_plies = 8;              // Random moves played from the opening, plus one half the time
+    int max_opening_score = 1000;      // Games whose first search scores beyond this are dropped
+    int max_plies = 400;               // Longer games are adjudicated as draws
+    uint64_t seed = 1;                 // Game n is the same for the same seed and options
+    std::string path;                  // Records are appended here, a whole game at a time
+};
+
+struct Progress {
+    uint64_t games = 0;
+    uint64_t positions = 0; // Records written
+    uint64_t white_wins = 0;
+    uint64_t draws = 0;
+    uint64_t black_wins = 0;
+};
+
+// Play self-play games on options.concurrency threads and append their quiet positions: not
+// in check, best move neither a capture nor a promotion, no mate or tablebase score. The random
+// opening moves are not recorded. on_game is called after every written game, one call at a
+// time. Setting stop ends the run after the games in progress.
+Progress generate(const Options &options, const std::function<void(const Progress &)> &on_game = nullptr,
+                  const std::atomic<bool> *stop = nullptr);
+
+} // namespace datagen
+} // namespace chess_engine
+
+#endif
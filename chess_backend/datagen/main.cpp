@@ -0,0 +1,137 @@
+#include "../generator/nnue.h"
+#include "../generator/search.h"
+#include "../generator/zobrist.h"
+#include "../selfplay/selfplay.h"
+#include "datagen.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <exception>
+#include <pthread.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace chess_engine;
+
+// Generates training data: fixed-node self-play games from randomized openings, whose quiet
+// positions are appended to a binary file of 32-byte records (see datagen.h).
+//
+// Usage: chess_datagen --out <file> [options]
+//   --out <file>               Data file, appended to
+//   --games <n>                Stop after n games
+//   --positions <n>            Stop once n positions are written (without either: until interrupted)
+//   --nodes <n>                Nodes per move (default 5000)
+//   --depth <n>                Depth per move instead of nodes
+//   --concurrency <n>          Games played at once (default: one per hardware thread)
+//   --hash <mb>                Table size of each game (default 16)
+//   --openings <file>          EPD file of starting positions (default: the initial position)
+//   --random-plies <n>         Random moves played from the opening, plus one half the time (default 8)
+//   --max-opening-score <cp>   Drop games that start more one-sided than this (default 1000)
+//   --max-plies <n>            Longer games are adjudicated as draws (default 400)
+//   --seed <n>                 Games are reproducible for a given seed (default 1)
+//   --eval-file <network>      Score with an NNUE network instead of the hand-written evaluation
+//   --report <n>               Print every n games (default 100)
+//
+// SIGINT or SIGTERM stops after the games in progress; the file always ends on a whole game.
+
+int main(int argc, char **argv) {
+    zobrist::init_zobrist_keys();
+
+    datagen::Options options;
+    options.limits.depth = search::MAX_DEPTH;
+    options.limits.nodes = 5000;
+    options.concurrency = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t report_every = 100;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            std::string value = argv[++i];
+
+            if (arg == "--out") {
+                options.path = value;
+            } else if (arg == "--games") {
+                options.games = std::stoull(value);
+            } else if (arg == "--positions") {
+                options.positions = std::stoull(value);
+            } else if (arg == "--nodes") {
+                options.limits.nodes = std::stoull(value);
+            } else if (arg == "--depth") {
+                options.limits.depth = std::stoi(value);
+                options.limits.nodes = 0;
+            } else if (arg == "--concurrency") {
+                options.concurrency = std::max(1, std::stoi(value));
+            } else if (arg == "--hash") {
+                options.hash_mb = std::max(1, std::stoi(value));
+            } else if (arg == "--openings") {
+                options.openings = selfplay::load_openings(value);
+            } else if (arg == "--random-plies") {
+                options.random_plies = std::max(0, std::stoi(value));
+            } else if (arg == "--max-opening-score") {
+                options.max_opening_score = std::stoi(value);
+            } else if (arg == "--max-plies") {
+                options.max_plies = std::stoi(value);
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(value);
+            } else if (arg == "--eval-file") {
+                if (!nnue::load(value)) {
+                    throw std::invalid_argument("cannot load NNUE network " + value);
+                }
+            } else if (arg == "--report") {
+                report_every = std::max(1ULL, std::stoull(value));
+            } else {
+                throw std::invalid_argument("unknown argument: " + arg);
+            }
+        }
+        if (options.path.empty()) {
+            throw std::invalid_argument("no output file given (--out)");
+        }
+
+        // Signals are taken by a thread of their own, which asks the workers to finish their games
+        static std::atomic<bool> stop{false};
+        sigset_t stop_signals;
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+        std::thread([stop_signals]() {
+            int signal = 0;
+            sigwait(&stop_signals, &signal);
+            std::fprintf(stderr, "stopping after the games in progress\n");
+            stop.store(true);
+        }).detach();
+
+        std::printf("writing to %s, %d games at once, %s per move\n", options.path.c_str(), options.concurrency,
+                    options.limits.nodes != 0 ? (std::to_string(options.limits.nodes) + " nodes").c_str()
+                                              : ("depth " + std::to_string(options.limits.depth)).c_str());
+        std::fflush(stdout);
+
+        auto start = std::chrono::steady_clock::now();
+        auto print = [&](const datagen::Progress &progress) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::printf("%llu games (+%llu =%llu -%llu), %llu positions, %.0f positions/s\n",
+                        static_cast<unsigned long long>(progress.games), static_cast<unsigned long long>(progress.white_wins),
+                        static_cast<unsigned long long>(progress.draws), static_cast<unsigned long long>(progress.black_wins),
+                        static_cast<unsigned long long>(progress.positions), progress.positions / std::max(elapsed.count(), 1e-9));
+            std::fflush(stdout);
+        };
+
+        datagen::Progress progress = datagen::generate(options, [&](const datagen::Progress &progress) {
+            if (progress.games % report_every == 0) {
+                print(progress);
+            }
+        }, &stop);
+        print(progress);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "chess_datagen: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
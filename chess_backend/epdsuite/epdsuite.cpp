@@ -0,0 +1,230 @@
+#include "epdsuite.h"
+#include "../generator/statistics.h"
+#include "../generator/transposition.h"
+#include "../structure/game_state.h"
+#include "../utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace chess_engine {
+namespace epdsuite {
+
+bool TestPosition::is_solution(const moves::Move &move) const {
+    if (!best_moves.empty() && std::find(best_moves.begin(), best_moves.end(), move) == best_moves.end()) {
+        return false;
+    }
+    return std::find(avoid_moves.begin(), avoid_moves.end(), move) == avoid_moves.end();
+}
+
+// Operations after the position fields, split on semicolons outside quoted strings
+std::vector<std::string> split_operations(const std::string &text) {
+    std::vector<std::string> operations;
+    std::string current;
+    bool quoted = false;
+    for (char c : text) {
+        if (c == '"') {
+            quoted = !quoted;
+        }
+        if (c == ';' && !quoted) {
+            operations.push_back(utils::trim(current));
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    if (!utils::trim(current).empty()) {
+        operations.push_back(utils::trim(current));
+    }
+    return operations;
+}
+
+// Moves of a bm or am operation, in SAN or, failing that, UCI notation
+bool parse_moves(const std::string &operands, game_state::GameState &state, std::vector<moves::Move> &result,
+                 std::string &error) {
+    std::istringstream words(operands);
+    std::string word;
+    while (words >> word) {
+        moves::Move move = moves::from_san(word, state);
+        if (move.is_null()) {
+            move = moves::from_uci(word, state);
+        }
+        if (move.is_null()) {
+            error = "no legal move " + word;
+            return false;
+        }
+        result.push_back(move);
+    }
+    return true;
+}
+
+// Take the id and the bm and am moves from the operations. Returns what is wrong with them, if
+// anything; throws std::invalid_argument if the position itself is invalid.
+std::string read_operations(const std::vector<std::string> &operations, TestPosition &position) {
+    game_state::GameState state = game_state::set_game_state(position.fen);
+    std::string error;
+    for (const auto &operation : operations) {
+        std::string opcode = operation.substr(0, operation.find(' '));
+        std::string operands = (operation.size() > opcode.size()) ? utils::trim(operation.substr(opcode.size())) : "";
+        if (opcode == "id") {
+            position.id = operands;
+            position.id.erase(std::remove(position.id.begin(), position.id.end(), '"'), position.id.end());
+        } else if (opcode == "bm" || opcode == "am") {
+            if (!parse_moves(operands, state, opcode == "bm" ? position.best_moves : position.avoid_moves, error)) {
+                return error;
+            }
+            position.expected += (position.expected.empty() ? "" : "; ") + opcode + " " + operands;
+        }
+    }
+    return error;
+}
+
+std::vector<TestPosition> load_suite(const std::string &path, std::vector<std::string> &errors) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    std::vector<TestPosition> suite;
+    std::string line;
+    for (int line_number = 1; std::getline(file, line); ++line_number) {
+        std::string where = path + ":" + std::to_string(line_number);
+        std::istringstream fields(line);
+        std::vector<std::string> parts;
+        std::string field;
+        while (parts.size() < 4 && fields >> field) {
+            parts.push_back(field);
+        }
+        if (parts.empty() || parts[0][0] == '#') {
+            continue;
+        }
+        if (parts.size() < 4) {
+            errors.push_back(where + ": expected four position fields");
+            continue;
+        }
+
+        std::string rest;
+        std::getline(fields, rest);
+        std::string halfmove = "0", fullmove = "1";
+
+        // A full FEN's move counters may stand in for the hmvc and fmvn operations
+        std::istringstream counters(rest);
+        std::string first, second;
+        if (counters >> first >> second && utils::is_number(first) && utils::is_number(second)) {
+            halfmove = first;
+            fullmove = second;
+            std::getline(counters, rest);
+        }
+
+        TestPosition position;
+        position.id = where;
+        std::vector<std::string> operations = split_operations(rest);
+        for (const auto &operation : operations) {
+            std::string opcode = operation.substr(0, operation.find(' '));
+            std::string operands = (operation.size() > opcode.size()) ? utils::trim(operation.substr(opcode.size())) : "";
+            if (opcode == "hmvc" && utils::is_number(operands)) {
+                halfmove = operands;
+            } else if (opcode == "fmvn" && utils::is_number(operands)) {
+                fullmove = operands;
+            }
+        }
+        position.fen = parts[0] + " " + parts[1] + " " + parts[2] + " " + parts[3] + " " + halfmove + " " + fullmove;
+
+        std::string error;
+        try {
+            error = read_operations(operations, position);
+        } catch (const std::invalid_argument &e) {
+            error = std::string("invalid position: ") + e.what();
+        }
+        if (!error.empty()) {
+            errors.push_back(where + ": " + error);
+        } else if (position.best_moves.empty() && position.avoid_moves.empty()) {
+            errors.push_back(where + ": no bm or am operation");
+        } else {
+            suite.push_back(position);
+        }
+    }
+    return suite;
+}
+
+PositionResult search_position(const TestPosition &position, const Options &options, transposition::TranspositionTable &table) {
+    PositionResult result;
+    game_state::GameState state = game_state::set_game_state(position.fen);
+
+    table.clear();
+    search::SearchState search_state;
+    search_state.table = &table;
+
+    // Every node is published to this thread's counters, the stopped last iteration included
+    uint64_t nodes_before = statistics::local_counters().nodes.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+
+    result.move = search::find_best_move(options.limits, state.turn, state, [&](const search::SearchInfo &info) {
+        if (info.multipv != 1 || info.pv.empty()) {
+            return;
+        }
+        result.score = info.score;
+        result.depth = info.depth;
+        if (!position.is_solution(info.pv.front())) {
+            result.solve_time_ms = -1;
+            result.solve_nodes = 0;
+        } else if (result.solve_time_ms < 0) {
+            result.solve_time_ms = info.time_ms;
+            result.solve_nodes = info.nodes;
+        }
+    }, nullptr, &search_state);
+
+    result.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    result.nodes = statistics::local_counters().nodes.load(std::memory_order_relaxed) - nodes_before;
+    result.solved = position.is_solution(result.move);
+
+    // A move changed in the stopped iteration, or chosen before any iteration completed
+    if (!result.solved) {
+        result.solve_time_ms = -1;
+        result.solve_nodes = 0;
+    } else if (result.solve_time_ms < 0) {
+        result.solve_time_ms = result.time_ms;
+        result.solve_nodes = result.nodes;
+    }
+    return result;
+}
+
+std::vector<PositionResult> run(const std::vector<TestPosition> &suite, const Options &options,
+                                const std::function<void(const PositionResult &)> &on_result) {
+    std::vector<PositionResult> results(suite.size());
+    std::mutex result_mutex;
+    std::atomic<size_t> next_position{0};
+
+    auto worker = [&]() {
+        transposition::TranspositionTable table(options.hash_mb);
+        for (size_t index = next_position.fetch_add(1); index < suite.size(); index = next_position.fetch_add(1)) {
+            PositionResult result = search_position(suite[index], options, table);
+            result.index = index;
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+            results[index] = result;
+            if (on_result) {
+                on_result(result);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::max(1, options.concurrency); ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    return results;
+}
+
+} // namespace epdsuite
+} // namespace chess_engine
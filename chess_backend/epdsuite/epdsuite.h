@@ -0,0 +1,61 @@
+#ifndef CHESS_ENGINE_EPDSUITE_H
+#define CHESS_ENGINE_EPDSUITE_H
+
+#include "../generator/search.h"
+#include "../moves/moves.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chess_engine {
+namespace epdsuite {
+
+// A test position: found when the search's move is one of the best moves (bm) and none of the
+// moves to avoid (am)
+struct TestPosition {
+    std::string id;  // The "id" operation, or the file and line number
+    std::string fen; // EPD fields completed with "0 1" when the move counters are missing
+    std::vector<moves::Move> best_moves;
+    std::vector<moves::Move> avoid_moves;
+    std::string expected; // The bm and am operations as written, for reports
+
+    bool is_solution(const moves::Move &move) const;
+};
+
+// Read a suite. Lines that have neither bm nor am, or whose position or moves cannot be read,
+// are left out and described in errors.
+std::vector<TestPosition> load_suite(const std::string &path, std::vector<std::string> &errors);
+
+struct Options {
+    search::SearchLimits limits; // Of every position's search
+    size_t hash_mb = 16;         // Private table per worker, cleared before every position
+    int concurrency = 1;         // Independent single-threaded searches at once
+};
+
+struct PositionResult {
+    size_t index = 0; // In the suite
+    moves::Move move; // The search's final choice
+    int score = 0;
+    int depth = 0; // Last completed iteration
+    bool solved = false;
+
+    // Time and nodes of the iteration from which the best move stayed a solution to the end,
+    // or -1 and 0 if the position was not solved
+    int64_t solve_time_ms = -1;
+    uint64_t solve_nodes = 0;
+
+    int64_t time_ms = 0;
+    uint64_t nodes = 0; // Every node of the search, the stopped iteration included
+};
+
+// Search every position on options.concurrency threads. on_result is called as each one
+// finishes, one call at a time; the results are returned in suite order.
+std::vector<PositionResult> run(const std::vector<TestPosition> &suite, const Options &options,
+                                const std::function<void(const PositionResult &)> &on_result = nullptr);
+
+} // namespace epdsuite
+} // namespace chess_engine
+
+#endif
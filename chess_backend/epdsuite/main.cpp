@@ -0,0 +1,201 @@
+#include "../generator/search.h"
+#include "../generator/zobrist.h"
+#include "epdsuite.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chess_engine;
+
+// Runs EPD test suites (WAC, ECM, STS, ...): searches every position with the same limits on a
+// pool of independent single-threaded searches and reports how many were solved, how soon, and
+// at what cost in nodes. With --nodes the outcome is the same on any machine and load, so runs
+// of two builds can be compared position by position through their JSON reports.
+//
+// Usage: chess_epdsuite [options] <suite.epd>...
+//   --movetime <ms>       Time per position (default 1000)
+//   --depth <n>           Depth per position
+//   --nodes <n>           Nodes per position
+//   --concurrency <n>     Positions searched at once (default: one per hardware thread)
+//   --hash <mb>           Table size of each search (default 16)
+//   --json <file>         Write the results of every position
+//   --failed              List only the positions that were not solved
+
+// Upper bounds of the time-to-solve buckets, in milliseconds
+const std::vector<int64_t> SOLVE_TIME_BUCKETS = {10, 100, 1000, 10000, 100000};
+
+std::string json_escape(const std::string &text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool write_json(const std::string &path, const std::vector<epdsuite::TestPosition> &suite,
+                const std::vector<epdsuite::PositionResult> &results, const search::SearchLimits &limits) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << "{\n";
+    out << "  \"context\": {\"date\": \"" << date << "\", \"positions\": " << suite.size() << ", \"movetime_ms\": "
+        << limits.movetime_ms << ", \"depth\": " << limits.depth << ", \"nodes\": " << limits.nodes << "},\n";
+    out << "  \"positions\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const epdsuite::PositionResult &result = results[i];
+        out << "    {\"id\": \"" << json_escape(suite[i].id) << "\", \"expected\": \"" << json_escape(suite[i].expected)
+            << "\", \"move\": \"" << moves::to_uci(result.move) << "\", \"solved\": " << (result.solved ? "true" : "false")
+            << ", \"solve_time_ms\": " << result.solve_time_ms << ", \"solve_nodes\": " << result.solve_nodes
+            << ", \"depth\": " << result.depth << ", \"score\": " << result.score << ", \"time_ms\": " << result.time_ms
+            << ", \"nodes\": " << result.nodes << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return true;
+}
+
+int main(int argc, char **argv) {
+    zobrist::init_zobrist_keys();
+
+    epdsuite::Options options;
+    options.limits.depth = search::MAX_DEPTH;
+    options.limits.movetime_ms = 1000;
+    options.concurrency = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> paths;
+    std::string json_path;
+    bool failed_only = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) != 0) {
+                paths.push_back(arg);
+                continue;
+            }
+            if (arg == "--failed") {
+                failed_only = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            std::string value = argv[++i];
+
+            if (arg == "--movetime") {
+                options.limits.movetime_ms = std::stoll(value);
+            } else if (arg == "--depth") {
+                options.limits.depth = std::stoi(value);
+                options.limits.movetime_ms = 0;
+            } else if (arg == "--nodes") {
+                options.limits.nodes = std::stoull(value);
+                options.limits.movetime_ms = 0;
+            } else if (arg == "--concurrency") {
+                options.concurrency = std::max(1, std::stoi(value));
+            } else if (arg == "--hash") {
+                options.hash_mb = std::max(1, std::stoi(value));
+            } else if (arg == "--json") {
+                json_path = value;
+            } else {
+                throw std::invalid_argument("unknown argument: " + arg);
+            }
+        }
+        if (paths.empty()) {
+            throw std::invalid_argument("no suite given");
+        }
+
+        std::vector<epdsuite::TestPosition> suite;
+        for (const auto &path : paths) {
+            std::vector<std::string> errors;
+            std::vector<epdsuite::TestPosition> positions = epdsuite::load_suite(path, errors);
+            for (const auto &error : errors) {
+                std::fprintf(stderr, "skipped %s\n", error.c_str());
+            }
+            suite.insert(suite.end(), positions.begin(), positions.end());
+        }
+        if (suite.empty()) {
+            throw std::invalid_argument("no test positions read");
+        }
+
+        std::printf("%zu positions, %d at once\n", suite.size(), options.concurrency);
+        std::fflush(stdout);
+
+        size_t finished = 0;
+        std::vector<epdsuite::PositionResult> results = epdsuite::run(suite, options, [&](const epdsuite::PositionResult &result) {
+            ++finished;
+            if (failed_only && result.solved) {
+                return;
+            }
+            const epdsuite::TestPosition &position = suite[result.index];
+            game_state::GameState state = game_state::set_game_state(position.fen);
+            std::printf("%4zu/%zu %-20s %-6s %-8s %-24s", finished, suite.size(), position.id.c_str(),
+                        result.solved ? "ok" : "FAIL", moves::to_san(result.move, state).c_str(), position.expected.c_str());
+            if (result.solved) {
+                std::printf(" solved in %lld ms, %llu nodes\n", static_cast<long long>(result.solve_time_ms),
+                            static_cast<unsigned long long>(result.solve_nodes));
+            } else {
+                std::printf(" depth %d\n", result.depth);
+            }
+            std::fflush(stdout);
+        });
+
+        size_t solved = 0;
+        uint64_t nodes = 0;
+        int64_t search_time_ms = 0;
+        std::vector<int64_t> solve_times;
+        for (const auto &result : results) {
+            nodes += result.nodes;
+            search_time_ms += result.time_ms;
+            if (result.solved) {
+                ++solved;
+                solve_times.push_back(result.solve_time_ms);
+            }
+        }
+        std::sort(solve_times.begin(), solve_times.end());
+
+        double cpu_seconds = std::max<int64_t>(search_time_ms, 1) / 1000.0;
+        std::printf("\nsolved %zu/%zu (%.1f%%), %llu nodes in %.1f CPU s (%.0f nps), %.2f solved per CPU s\n", solved, suite.size(),
+                    100.0 * solved / suite.size(), static_cast<unsigned long long>(nodes), cpu_seconds, nodes / cpu_seconds,
+                    solved / cpu_seconds);
+        if (!solve_times.empty()) {
+            int64_t total = 0;
+            for (int64_t time : solve_times) {
+                total += time;
+            }
+            std::printf("time to solve: median %lld ms, mean %lld ms, max %lld ms\n",
+                        static_cast<long long>(solve_times[solve_times.size() / 2]),
+                        static_cast<long long>(total / static_cast<int64_t>(solve_times.size())),
+                        static_cast<long long>(solve_times.back()));
+            for (int64_t bucket : SOLVE_TIME_BUCKETS) {
+                size_t count = std::upper_bound(solve_times.begin(), solve_times.end(), bucket - 1) - solve_times.begin();
+                std::printf("  < %6lld ms: %zu\n", static_cast<long long>(bucket), count);
+                if (count == solve_times.size()) {
+                    break;
+                }
+            }
+        }
+
+        if (!json_path.empty() && !write_json(json_path, suite, results, options.limits)) {
+            throw std::runtime_error("cannot write " + json_path);
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "chess_epdsuite: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "book.h"
+#include "../enums.h"
+#include "../utils.h"
+#include "statistics.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+namespace chess_engine {
+namespace book {
+
+// The open book, mapped read-only; searches only ever read it
+std::unique_ptr<utils::MappedFile> book_file;
+const unsigned char *book_data = nullptr;
+size_t book_size = 0;
+
+std::atomic<int> ply_limit{DEFAULT_MAX_PLY};
+
+bool open(const std::string &path) {
+    close();
+    if (path.empty()) {
+        return false;
+    }
+
+    // Probes binary search scattered pages; let the kernel fault them in one at a time
+    std::unique_ptr<utils::MappedFile> file;
+    try {
+        file = std::make_unique<utils::MappedFile>(path, utils::MappedFile::Access::RANDOM);
+    } catch (const std::runtime_error &) {
+        return false;
+    }
+    if (file->size() == 0 || file->size() % ENTRY_SIZE != 0) {
+        return false;
+    }
+
+    book_data = reinterpret_cast<const unsigned char *>(file->data());
+    book_size = file->size();
+    book_file = std::move(file);
+    return true;
+}
+
+void close() {
+    book_file.reset();
+    book_data = nullptr;
+    book_size = 0;
+}
+
+bool is_open() {
+    return book_data != nullptr;
+}
+
+size_t size() {
+    return book_size / ENTRY_SIZE;
+}
+
+void set_max_ply(int ply) {
+    ply_limit.store(std::max(0, ply), std::memory_order_relaxed);
+}
+
+int max_ply() {
+    return ply_limit.load(std::memory_order_relaxed);
+}
+
+uint64_t read_big_endian(const unsigned char *bytes, int count) {
+    uint64_t value = 0;
+    for (int i = 0; i < count; ++i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+uint64_t key_at(size_t index) {
+    return read_big_endian(book_data + index * ENTRY_SIZE, 8);
+}
+
+Entry entry_at(size_t index) {
+    const unsigned char *bytes = book_data + index * ENTRY_SIZE;
+    Entry entry;
+    entry.key = read_big_endian(bytes, 8);
+    entry.move = static_cast<uint16_t>(read_big_endian(bytes + 8, 2));
+    entry.weight = static_cast<uint16_t>(read_big_endian(bytes + 10, 2));
+    entry.learn = static_cast<uint32_t>(read_big_endian(bytes + 12, 4));
+    return entry;
+}
+
+std::vector<Entry> lookup(uint64_t key) {
+    std::vector<Entry> entries;
+    if (!is_open()) {
+        return entries;
+    }
+
+    // First entry with the key
+    size_t low = 0, high = size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (key_at(middle) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (size_t i = low; i < size() && key_at(i) == key; ++i) {
+        entries.push_back(entry_at(i));
+    }
+    return entries;
+}
+
+uint16_t encode_move(const moves::Move &move) {
+    int to = move.to;
+    if (move.move_type == moves::Type::CASTLING) {
+        to = (move.to % 8 == 6) ? move.from + 3 : move.from - 4;
+    }
+
+    int promotion = 0;
+    if (move.promotion != piece::Type::EMPTY) {
+        promotion = move.promotion; // KNIGHT = 1 ... QUEEN = 4, as in Polyglot
+    }
+    return static_cast<uint16_t>(to | (move.from << 6) | (promotion << 12));
+}
+
+moves::Move decode_move(uint16_t move, game_state::GameState &state) {
+    for (const auto &legal : moves::generate_legal_moves(state.turn, state)) {
+        if (encode_move(legal) == move) {
+            return legal;
+        }
+    }
+    return moves::Move();
+}
+
+bool probe(game_state::GameState &state, moves::Move &move) {
+    if (!is_open()) {
+        return false;
+    }
+
+    int ply = 2 * (state.fullmove_number - 1) + (state.turn == piece::Color::BLACK ? 1 : 0);
+    if (ply >= max_ply()) {
+        return false;
+    }
+
+    statistics::ThreadCounters &counters = statistics::local_counters();
+    statistics::add(counters.book_probes, 1);
+
+    // Entries whose move is illegal here (key collisions, corrupt books) are skipped
+    std::vector<moves::Move> candidates;
+    std::vector<uint32_t> weights;
+    for (const auto &entry : lookup(zobrist::polyglot_hash(state))) {
+        moves::Move candidate = decode_move(entry.move, state);
+        if (!candidate.is_null() && entry.weight > 0) {
+            candidates.push_back(candidate);
+            weights.push_back(entry.weight);
+        }
+    }
+    if (candidates.empty()) {
+        return false;
+    }
+
+    thread_local std::mt19937_64 gen(std::random_device{}());
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    move = candidates[pick(gen)];
+
+    statistics::add(counters.book_hits, 1);
+    return true;
+}
+
+} // namespace book
+} // namespace chess_engine
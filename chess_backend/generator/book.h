@@ -0,0 +1,56 @@
+#ifndef CHESS_ENGINE_BOOK_H
+#define CHESS_ENGINE_BOOK_H
+
+#include "../moves/moves.h"
+#include "../structure/game_state.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace chess_engine {
+namespace book {
+
+// One book move, as stored in a Polyglot .bin file: 16 big-endian bytes, sorted by key
+struct Entry {
+    uint64_t key;    // zobrist::polyglot_hash of the position
+    uint16_t move;   // See encode_move
+    uint16_t weight; // Relative frequency of the move among those of the position
+    uint32_t learn;  // Unused
+};
+
+constexpr size_t ENTRY_SIZE = 16;
+
+// Book moves are played up to this ply (half-move) of the game unless configured otherwise
+constexpr int DEFAULT_MAX_PLY = 20;
+
+// Memory-map a book, replacing the open one. An empty path closes it. Must not be called while
+// a search is running. Returns false if the file cannot be mapped or is not a whole number of
+// entries.
+bool open(const std::string &path);
+void close();
+bool is_open();
+
+// Number of entries of the open book
+size_t size();
+
+// Plies of a game during which the book is consulted
+void set_max_ply(int ply);
+int max_ply();
+
+// Polyglot move encoding: to square in bits 0-5, from square in bits 6-11 (a1 = 0, as ours),
+// promotion piece in bits 12-14 (1 knight ... 4 queen). Castling is written king takes rook.
+uint16_t encode_move(const moves::Move &move);
+moves::Move decode_move(uint16_t move, game_state::GameState &state);
+
+// Entries of a position, in file order
+std::vector<Entry> lookup(uint64_t key);
+
+// Pick a book move with probability proportional to its weight. Fails when no book is open,
+// the game is past the ply limit or the position has no legal book move.
+bool probe(game_state::GameState &state, moves::Move &move);
+
+} // namespace book
+} // namespace chess_engine
+
+#endif
@@ -6,13 +6,64 @@
 #include "../structure/board.h"
 #include "../structure/game_state.h"
 #include "../structure/square.h"
+#include "search.h"
 
 namespace chess_engine {
 namespace evaluate {
 
+// Score of the side to move when it is checkmated, negated
+constexpr int MATE_SCORE = 9999999;
+
+// Mates are scored MATE_SCORE minus their distance in plies from the root, so scores
+// within MAX_MATE_PLY of MATE_SCORE are mates rather than evaluations
+constexpr int MAX_MATE_PLY = 1000;
+
+inline bool is_mate_score(int score) {
+    return score >= MATE_SCORE - MAX_MATE_PLY || score <= -MATE_SCORE + MAX_MATE_PLY;
+}
+
+// Tablebase wins rank below every mate and above every evaluation. Like mates, they are scored
+// by distance from the root and stored in the TT relative to the node.
+constexpr int TB_WIN_SCORE = MATE_SCORE - 2 * MAX_MATE_PLY;
+
+// Moves until mate in a mate score, negative when the side to move is getting mated (UCI "score mate")
+int mate_in_moves(int score);
+
+// Tablebase wins are reported to users as TB_WIN_CP minus their distance in plies, keeping them
+// above any evaluation without leaking the internal score range
+constexpr int TB_WIN_CP = 20000;
+
+// Centipawns to report for a non-mate score
+int to_centipawns(int score);
+
+// The transposition table stores mate and tablebase distances from the stored node instead of the root
+int score_to_tt(int score, int ply);
+int score_from_tt(int score, int ply);
+
 int evaluate(piece::Color color, game_state::GameState &state);
+int evaluate(piece::Color color, game_state::GameState &state, search::SearchContext &ctx);
 int piece_value(piece::Type type);
-int quiescence(int alpha, int beta, piece::Color color, game_state::GameState &state, int depth = 0);
+
+// Static evaluation for the side to move, scoring checkmate and draws; no search
+int evaluate_position(piece::Color color, game_state::GameState &state);
+int quiescence(int alpha, int beta, piece::Color color, game_state::GameState &state, search::SearchContext &ctx, int ply = 0, int depth = 0);
+
+// Phase of the game from the pieces left: MAX_PHASE in the opening, 0 with only kings and pawns.
+// The piece-square tables blend from their middlegame to their endgame values with it.
+constexpr int MAX_PHASE = 24;
+int game_phase(const board::Board &board);
+
+// What the pawn and king terms of the hand-written evaluation count, White's minus Black's.
+// Shared with the tuner, which fits the weight of each.
+struct PawnKingTerms {
+    int doubled_files = 0;  // Files with more than one pawn
+    int isolated_files = 0; // Files whose pawns have no pawn on an adjacent file
+    int shield_pawns = 0;   // Pawns on the three squares in front of the king
+};
+PawnKingTerms pawn_king_terms(const board::Board &board);
+
+// Static exchange evaluation of a capture, in centipawns for the capturing side
+int see(const game_state::GameState &state, const moves::Move &move);
 
 } // namespace evaluate
 } // namespace chess_engine
@@ -0,0 +1,276 @@
+#include "nnue.h"
+#include "../structure/board.h"
+#include "../structure/game_state.h"
+#include "../utils.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace chess_engine {
+namespace nnue {
+
+struct Network {
+    alignas(64) int16_t feature_weights[INPUTS * HIDDEN]; // One column of HIDDEN weights per feature
+    alignas(64) int16_t feature_biases[HIDDEN];
+    alignas(64) int16_t output_weights[2 * HIDDEN];
+    int16_t output_bias;
+};
+
+std::unique_ptr<Network> network;
+uint32_t network_id = 0; // Incremented on every load, so accumulators of an older network are stale
+std::atomic<bool> enabled{true};
+
+// Replaying more moves than this costs about as much as recomputing from the board
+constexpr size_t MAX_REPLAY = 8;
+
+// Most pieces a move adds or removes: castling moves two and a capture removes two
+constexpr int MAX_CHANGES = 2;
+
+struct Piece {
+    piece::Color color;
+    piece::Type type;
+    int square;
+};
+
+struct Changes {
+    Piece added[MAX_CHANGES];
+    Piece removed[MAX_CHANGES];
+    int added_count = 0;
+    int removed_count = 0;
+};
+
+// Weight column of a piece seen from one side
+inline const int16_t *column(piece::Color perspective, const Piece &piece) {
+    int square = (perspective == piece::Color::WHITE) ? piece.square : piece.square ^ 56;
+    int feature = (piece.color == perspective ? 0 : 384) + 64 * piece.type + square;
+    return &network->feature_weights[feature * HIDDEN];
+}
+
+// out = in + the added columns - the removed ones
+void update(const int16_t *in, int16_t *out, const int16_t *const *added, int added_count,
+            const int16_t *const *removed, int removed_count) {
+#if defined(__AVX2__)
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i values = _mm256_load_si256(reinterpret_cast<const __m256i *>(in + i));
+        for (int j = 0; j < added_count; ++j) {
+            values = _mm256_add_epi16(values, _mm256_load_si256(reinterpret_cast<const __m256i *>(added[j] + i)));
+        }
+        for (int j = 0; j < removed_count; ++j) {
+            values = _mm256_sub_epi16(values, _mm256_load_si256(reinterpret_cast<const __m256i *>(removed[j] + i)));
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i *>(out + i), values);
+    }
+#elif defined(__SSE2__)
+    for (int i = 0; i < HIDDEN; i += 8) {
+        __m128i values = _mm_load_si128(reinterpret_cast<const __m128i *>(in + i));
+        for (int j = 0; j < added_count; ++j) {
+            values = _mm_add_epi16(values, _mm_load_si128(reinterpret_cast<const __m128i *>(added[j] + i)));
+        }
+        for (int j = 0; j < removed_count; ++j) {
+            values = _mm_sub_epi16(values, _mm_load_si128(reinterpret_cast<const __m128i *>(removed[j] + i)));
+        }
+        _mm_store_si128(reinterpret_cast<__m128i *>(out + i), values);
+    }
+#else
+    for (int i = 0; i < HIDDEN; ++i) {
+        int16_t value = in[i];
+        for (int j = 0; j < added_count; ++j) {
+            value += added[j][i];
+        }
+        for (int j = 0; j < removed_count; ++j) {
+            value -= removed[j][i];
+        }
+        out[i] = value;
+    }
+#endif
+}
+
+// Dot product of both clipped accumulators with the output weights
+int32_t output(const int16_t *us, const int16_t *them, const int16_t *weights) {
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ceiling = _mm256_set1_epi16(QA);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i ours = _mm256_load_si256(reinterpret_cast<const __m256i *>(us + i));
+        __m256i theirs = _mm256_load_si256(reinterpret_cast<const __m256i *>(them + i));
+        ours = _mm256_min_epi16(_mm256_max_epi16(ours, zero), ceiling);
+        theirs = _mm256_min_epi16(_mm256_max_epi16(theirs, zero), ceiling);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(ours, _mm256_load_si256(reinterpret_cast<const __m256i *>(weights + i))));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(theirs, _mm256_load_si256(reinterpret_cast<const __m256i *>(weights + HIDDEN + i))));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ceiling = _mm_set1_epi16(QA);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < HIDDEN; i += 8) {
+        __m128i ours = _mm_load_si128(reinterpret_cast<const __m128i *>(us + i));
+        __m128i theirs = _mm_load_si128(reinterpret_cast<const __m128i *>(them + i));
+        ours = _mm_min_epi16(_mm_max_epi16(ours, zero), ceiling);
+        theirs = _mm_min_epi16(_mm_max_epi16(theirs, zero), ceiling);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(ours, _mm_load_si128(reinterpret_cast<const __m128i *>(weights + i))));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(theirs, _mm_load_si128(reinterpret_cast<const __m128i *>(weights + HIDDEN + i))));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < HIDDEN; ++i) {
+        int32_t ours = std::min<int32_t>(std::max<int32_t>(us[i], 0), QA);
+        int32_t theirs = std::min<int32_t>(std::max<int32_t>(them[i], 0), QA);
+        sum += ours * weights[i] + theirs * weights[HIDDEN + i];
+    }
+    return sum;
+#endif
+}
+
+// Pieces a recorded move took off and put on the board
+Changes changes_of(const moves::Reversible_Move &record) {
+    const moves::Move &move = record.move;
+    piece::Color opponent = utils::opposite_color(move.color);
+    piece::Type placed = (move.move_type == moves::PROMOTION) ? move.promotion : move.piece_type;
+
+    Changes changes;
+    changes.removed[changes.removed_count++] = {move.color, move.piece_type, move.from};
+    changes.added[changes.added_count++] = {move.color, placed, move.to};
+
+    if (record.captured_piece != piece::Type::EMPTY) {
+        changes.removed[changes.removed_count++] = {opponent, record.captured_piece, move.to};
+    } else if (move.move_type == moves::EN_PASSANT) {
+        int captured_square = (move.color == piece::Color::WHITE) ? move.to - 8 : move.to + 8;
+        changes.removed[changes.removed_count++] = {opponent, piece::Type::PAWN, captured_square};
+    } else if (move.move_type == moves::CASTLING) {
+        bool kingside = (move.to % 8) == 6;
+        int rank_start = move.to - move.to % 8;
+        changes.removed[changes.removed_count++] = {move.color, piece::Type::ROOK, rank_start + (kingside ? 7 : 0)};
+        changes.added[changes.added_count++] = {move.color, piece::Type::ROOK, rank_start + (kingside ? 5 : 3)};
+    }
+    return changes;
+}
+
+// Accumulator of the position after a move, from the one before it
+void apply(const Accumulator &before, Accumulator &after, const moves::Reversible_Move &record) {
+    Changes changes = changes_of(record);
+    for (piece::Color perspective : {piece::Color::WHITE, piece::Color::BLACK}) {
+        const int16_t *added[MAX_CHANGES];
+        const int16_t *removed[MAX_CHANGES];
+        for (int i = 0; i < changes.added_count; ++i) {
+            added[i] = column(perspective, changes.added[i]);
+        }
+        for (int i = 0; i < changes.removed_count; ++i) {
+            removed[i] = column(perspective, changes.removed[i]);
+        }
+        update(before.values[perspective], after.values[perspective], added, changes.added_count, removed, changes.removed_count);
+    }
+    after.network = network_id;
+}
+
+void refresh(Accumulator &accumulator, const board::Board &board) {
+    for (piece::Color perspective : {piece::Color::WHITE, piece::Color::BLACK}) {
+        const int16_t *added[32];
+        int count = 0;
+        for (piece::Color color : {piece::Color::WHITE, piece::Color::BLACK}) {
+            for (int type = piece::Type::PAWN; type <= piece::Type::KING; ++type) {
+                bit::Bitboard pieces = board.get_pieces(static_cast<piece::Type>(type), color);
+                while (pieces != 0 && count < 32) {
+                    int square = __builtin_ctzll(pieces);
+                    pieces &= pieces - 1;
+                    added[count++] = column(perspective, {color, static_cast<piece::Type>(type), square});
+                }
+            }
+        }
+        update(network->feature_biases, accumulator.values[perspective], added, count, nullptr, 0);
+    }
+    accumulator.network = network_id;
+}
+
+int evaluate(piece::Color color, const game_state::GameState &state) {
+    std::vector<Accumulator> &stack = state.accumulators;
+    size_t ply = state.move_history.size();
+    if (stack.size() <= ply) {
+        stack.resize(ply + 1);
+    }
+
+    if (stack[ply].network != network_id) {
+        size_t base = ply;
+        while (base > 0 && ply - base < MAX_REPLAY && stack[base].network != network_id) {
+            --base;
+        }
+        if (stack[base].network != network_id) {
+            refresh(stack[ply], state.board);
+        } else {
+            for (size_t i = base; i < ply; ++i) {
+                apply(stack[i], stack[i + 1], state.move_history[i]);
+            }
+        }
+    }
+
+    const Accumulator &accumulator = stack[ply];
+    int64_t sum = output(accumulator.values[color], accumulator.values[utils::opposite_color(color)], network->output_weights);
+    return static_cast<int>((sum + network->output_bias) * SCALE / (QA * QB));
+}
+
+bool load(const std::string &path) {
+    constexpr std::streamoff EXPECTED_BYTES = sizeof(int16_t) * (INPUTS * HIDDEN + HIDDEN + 2 * HIDDEN + 1);
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::streamoff bytes = file.tellg();
+    if (bytes < EXPECTED_BYTES || bytes > (EXPECTED_BYTES + 63) / 64 * 64) {
+        return false;
+    }
+
+    auto loaded = std::make_unique<Network>();
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(loaded->feature_weights), sizeof(loaded->feature_weights));
+    file.read(reinterpret_cast<char *>(loaded->feature_biases), sizeof(loaded->feature_biases));
+    file.read(reinterpret_cast<char *>(loaded->output_weights), sizeof(loaded->output_weights));
+    file.read(reinterpret_cast<char *>(&loaded->output_bias), sizeof(loaded->output_bias));
+    if (!file) {
+        return false;
+    }
+
+    network = std::move(loaded);
+    ++network_id;
+    return true;
+}
+
+bool is_loaded() {
+    return network != nullptr;
+}
+
+void set_enabled(bool enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool is_enabled() {
+    return network != nullptr && enabled.load(std::memory_order_relaxed);
+}
+
+const char *simd_name() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace nnue
+} // namespace chess_engine
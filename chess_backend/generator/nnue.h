@@ -0,0 +1,61 @@
+#ifndef CHESS_ENGINE_NNUE_H
+#define CHESS_ENGINE_NNUE_H
+
+#include "../enums.h"
+#include <cstdint>
+#include <string>
+
+namespace chess_engine {
+namespace board {
+class Board;
+}
+namespace game_state {
+class GameState;
+}
+namespace nnue {
+
+// A (768 -> 256) x 2 -> 1 network. Each side has its own 256-wide accumulator over the 768
+// piece-square features seen from that side (board flipped for Black, own pieces first); the
+// side to move's accumulator and the other's, clipped to [0, QA], feed a single output neuron.
+//
+// Weights file: little-endian int16 values, in order
+//   feature weights  [768][256]   feature = (theirs ? 384 : 0) + 64 * piece type + square
+//   feature biases   [256]
+//   output weights   [2][256]     side to move's half first
+//   output bias      [1]          quantized by QA * QB
+// optionally zero-padded to a multiple of 64 bytes.
+constexpr int INPUTS = 768;
+constexpr int HIDDEN = 256;
+constexpr int QA = 255;    // Accumulator quantization; activations are clipped to [0, QA]
+constexpr int QB = 64;     // Output weight quantization
+constexpr int SCALE = 400; // Output to centipawns
+
+struct alignas(64) Accumulator {
+    int16_t values[2][HIDDEN]; // Indexed by perspective
+    uint32_t network = 0;      // Id of the network the values were computed with, 0 if stale
+};
+
+// Replace the network with the one in a weights file. Returns false, keeping the current
+// network, if the file cannot be read or has the wrong size. Must not be called while a search
+// is running.
+bool load(const std::string &path);
+bool is_loaded();
+
+// Whether evaluation uses the network (when one is loaded) instead of the hand-written terms
+void set_enabled(bool enabled);
+bool is_enabled();
+
+// Instruction set the inference kernels were compiled for: "avx2", "sse2" or "scalar"
+const char *simd_name();
+
+// Score of the position for the given color in centipawns. The accumulator of the current ply
+// is brought up to date from the nearest computed one on the line, or recomputed from the board.
+int evaluate(piece::Color color, const game_state::GameState &state);
+
+// Recompute an accumulator from every piece on the board
+void refresh(Accumulator &accumulator, const board::Board &board);
+
+} // namespace nnue
+} // namespace chess_engine
+
+#endif
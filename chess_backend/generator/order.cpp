@@ -18,7 +18,56 @@ constexpr int MVV_LVA[6][6] = {
     {0, 0, 0, 0, 0, 0}        // Victim King
 };
 
-std::vector<moves::Move> order_moves(const std::vector<moves::Move> &moves, const game_state::GameState &game_state) {
+// Captures and promotions are searched before killers, killers before other quiet moves
+constexpr int CAPTURE_BONUS = 1000;
+constexpr int KILLER_BONUS[2] = {900, 800};
+constexpr int HISTORY_MAX = 700;
+
+bool is_quiet(const moves::Move &move) {
+    return move.move_type != moves::Type::CAPTURE && move.move_type != moves::Type::EN_PASSANT &&
+           move.move_type != moves::Type::PROMOTION;
+}
+
+Heuristics::Heuristics() {
+    clear();
+}
+
+void Heuristics::clear() {
+    for (auto &ply_killers : killers) {
+        ply_killers[0] = moves::Move();
+        ply_killers[1] = moves::Move();
+    }
+    std::fill(&history[0][0][0], &history[0][0][0] + 2 * 64 * 64, 0);
+}
+
+void Heuristics::advance(int plies) {
+    if (plies <= 0) {
+        return;
+    }
+
+    // What was ply N of the previous search is ply N - plies of the next one
+    for (int ply = 0; ply < MAX_PLY; ++ply) {
+        for (int slot = 0; slot < 2; ++slot) {
+            killers[ply][slot] = (ply + plies < MAX_PLY) ? killers[ply + plies][slot] : moves::Move();
+        }
+    }
+
+    // Older cutoffs count for less
+    std::for_each(&history[0][0][0], &history[0][0][0] + 2 * 64 * 64, [](int &score) { score /= 2; });
+}
+
+void Heuristics::record_cutoff(const moves::Move &move, int ply, int depth) {
+    if (ply < MAX_PLY && killers[ply][0] != move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+
+    int &score = history[move.color][move.from][move.to];
+    score = std::min(score + depth * depth, HISTORY_MAX);
+}
+
+std::vector<moves::Move> order_moves(const std::vector<moves::Move> &moves, const game_state::GameState &game_state,
+                                     const Heuristics *heuristics, int ply) {
     std::vector<std::pair<int, moves::Move>> scored_moves;
     scored_moves.reserve(moves.size());
 
@@ -29,7 +78,7 @@ std::vector<moves::Move> order_moves(const std::vector<moves::Move> &moves, cons
         if (move.move_type == moves::Type::CAPTURE) {
             piece::Type victim = game_state.get_board().get_piece_type(move.to);
             piece::Type attacker = move.piece_type;
-            score += MVV_LVA[victim][attacker];
+            score += CAPTURE_BONUS + MVV_LVA[victim][attacker];
         }
 
         // Prioritize promotions
@@ -67,13 +116,16 @@ std::vector<moves::Move> order_moves(const std::vector<moves::Move> &moves, cons
         // For simplicity, omit this for now
         // }
 
-        // Use history heuristic
-        // This would require maintaining a history table
-        // score += history_table[move.from][move.to];
-
-        // Killer move heuristic
-        // This would require maintaining killer moves for each ply
-        // if (is_killer_move(move, ply)) score += 50;
+        // Killer and history heuristics for quiet moves
+        if (heuristics != nullptr && is_quiet(move)) {
+            if (ply < MAX_PLY && move == heuristics->killers[ply][0]) {
+                score += KILLER_BONUS[0];
+            } else if (ply < MAX_PLY && move == heuristics->killers[ply][1]) {
+                score += KILLER_BONUS[1];
+            } else {
+                score += heuristics->history[move.color][move.from][move.to];
+            }
+        }
 
         scored_moves.emplace_back(score, move);
     }
@@ -7,7 +7,30 @@
 namespace chess_engine {
 namespace order {
 
-std::vector<moves::Move> order_moves(const std::vector<moves::Move> &moves, const game_state::GameState &game_state);
+constexpr int MAX_PLY = 128;
+
+// Quiet-move ordering memory. It is ply-relative, so it can be carried from one
+// search to the next within a game (see advance).
+struct Heuristics {
+    moves::Move killers[MAX_PLY][2]; // Two most recent quiet moves that caused a beta cutoff at each ply
+    int history[2][64][64];          // Cutoff counts by side, from-square and to-square
+
+    Heuristics();
+
+    void clear();
+
+    // Re-base the tables after the game moved forward by the given number of plies
+    void advance(int plies);
+
+    // Remember a quiet move that caused a beta cutoff
+    void record_cutoff(const moves::Move &move, int ply, int depth);
+};
+
+// Moves that neither capture nor promote
+bool is_quiet(const moves::Move &move);
+
+std::vector<moves::Move> order_moves(const std::vector<moves::Move> &moves, const game_state::GameState &game_state,
+                                     const Heuristics *heuristics = nullptr, int ply = 0);
 
 } // namespace order
 } // namespace chess_engine
@@ -2,14 +2,22 @@
 #include "../moves/moves.h"
 #include "../structure/game_state.h"
 #include "../structure/square.h"
+#include "book.h"
 #include "evaluate.h"
 #include "order.h"
+#include "search.h"
+#include "statistics.h"
+#include "tablebase.h"
 #include "transposition.h"
 #include "zobrist.h"
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <stdexcept>
 #include <thread>
 #include <utility>
@@ -18,41 +26,223 @@
 namespace chess_engine {
 namespace search {
 
-const int INF = std::numeric_limits<int>::max();
-const int NEG_INF = std::numeric_limits<int>::min();
+transposition::TranspositionTable tt(64); // 64 MB table
 
-// Declare the global transposition table (defined in main.cpp)
-extern transposition::TranspositionTable tt;
+int thread_count = 1;
+
+// Searches using tt, and whether a resize or clear is waiting for them or running
+std::mutex tt_gate_mutex;
+std::condition_variable tt_gate_changed;
+int tt_searches = 0;
+bool tt_maintenance = false;
+std::atomic<bool> tt_quiesce{false}; // Running searches on tt stop at their next limit check
+
+// Held for the whole of a search on tt
+class TableUse {
+  public:
+    explicit TableUse(const transposition::TranspositionTable *table) : shared(table == &tt) {
+        if (shared) {
+            std::unique_lock<std::mutex> lock(tt_gate_mutex);
+            tt_gate_changed.wait(lock, []() { return !tt_maintenance; });
+            ++tt_searches;
+        }
+    }
+
+    ~TableUse() {
+        if (shared) {
+            std::lock_guard<std::mutex> lock(tt_gate_mutex);
+            --tt_searches;
+            tt_gate_changed.notify_all();
+        }
+    }
+
+  private:
+    bool shared;
+};
+
+// Counted as one running search in the statistics for its whole duration, however many
+// threads it uses
+class ActiveSearch {
+  public:
+    ActiveSearch() {
+        statistics::search_started();
+        statistics::add(statistics::local_counters().searches, 1);
+    }
+
+    ~ActiveSearch() {
+        statistics::search_finished();
+    }
+};
+
+// Run an operation on tt once no search is using it
+template <typename Operation>
+void with_quiet_tt(Operation operation) {
+    {
+        std::unique_lock<std::mutex> lock(tt_gate_mutex);
+        tt_gate_changed.wait(lock, []() { return !tt_maintenance; });
+        tt_maintenance = true;
+        tt_quiesce.store(true, std::memory_order_relaxed);
+        tt_gate_changed.wait(lock, []() { return tt_searches == 0; });
+        tt_quiesce.store(false, std::memory_order_relaxed);
+    }
+
+    // Searches are let back in even if the operation throws
+    struct MaintenanceEnd {
+        ~MaintenanceEnd() {
+            std::lock_guard<std::mutex> lock(tt_gate_mutex);
+            tt_maintenance = false;
+            tt_gate_changed.notify_all();
+        }
+    } maintenance_end;
+
+    operation();
+}
+
+void resize_tt(size_t size_mb) {
+    with_quiet_tt([size_mb]() { tt.resize(size_mb); });
+}
+
+void clear_tt() {
+    with_quiet_tt([]() { tt.clear(); });
+}
+
+bool save_tt(const std::string &path) {
+    bool saved = false;
+    with_quiet_tt([&path, &saved]() { saved = tt.save(path); });
+    return saved;
+}
+
+void SearchState::push_position(const game_state::GameState &game_state) {
+    key_history.push_back(zobrist::compute_hash(game_state));
+}
+
+// True if the position repeats one reached since the last capture or pawn move
+bool is_repetition(const SearchContext &ctx, uint64_t hash, int halfmove_clock) {
+    const std::vector<uint64_t> &keys = ctx.state->key_history;
+    int reachable = std::min<int>(halfmove_clock, static_cast<int>(keys.size()));
+
+    // Only positions with the same side to move can match: every second one
+    for (int distance = 2; distance <= reachable; distance += 2) {
+        if (keys[keys.size() - distance] == hash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Score of a tablebase result; the fifty-move rule turns cursed wins and blessed losses into draws
+int tablebase_score(tablebase::Wdl wdl, int ply) {
+    switch (wdl) {
+    case tablebase::Wdl::WIN:
+        return evaluate::TB_WIN_SCORE - ply;
+    case tablebase::Wdl::LOSS:
+        return -evaluate::TB_WIN_SCORE + ply;
+    default:
+        return 0;
+    }
+}
+
+std::pair<int, moves::Move> negamax(int depth, int alpha, int beta, piece::Color color, game_state::GameState &game_state, SearchContext &ctx) {
+    ++ctx.nodes;
+
+    if (should_stop(ctx)) {
+        return {0, moves::Move()};
+    }
 
-std::pair<int, moves::Move> negamax(int depth, int alpha, int beta, piece::Color color, game_state::GameState &game_state) {
     uint64_t hash = zobrist::compute_hash(game_state);
+    int ply = static_cast<int>(ctx.state->key_history.size() - ctx.root_ply);
+    ctx.pv_table->clear(ply);
+
+    // Any repetition inside the tree is scored as a draw
+    if (ply > 0 && is_repetition(ctx, hash, game_state.halfmove_clock)) {
+        return {0, moves::Move()};
+    }
+
+    // Later MultiPV passes search the root without some of its moves, so they do not
+    // overwrite the root entry
+    bool partial_root = ply == 0 && !ctx.excluded_root_moves.empty();
 
     // Probe the transposition table
     int tt_score;
     transposition::NodeType tt_type;
     moves::Move tt_move;
-    if (tt.probe(hash, depth, tt_score, tt_type, tt_move)) {
-        if (tt_type == transposition::NodeType::EXACT) {
-            return {tt_score, tt_move};
-        } else if (tt_type == transposition::NodeType::ALPHA && tt_score <= alpha) {
-            return {alpha, tt_move};
-        } else if (tt_type == transposition::NodeType::BETA && tt_score >= beta) {
-            return {beta, tt_move};
+    ++ctx.tt_probes;
+    if (ctx.table->probe(hash, depth, tt_score, tt_type, tt_move)) {
+        ++ctx.tt_hits;
+        tt_score = evaluate::score_from_tt(tt_score, ply);
+
+        // The root always searches its moves: its result is the move played, and after a key
+        // collision the entry's move may not even be legal here
+        if (ply > 0) {
+            if (tt_type == transposition::NodeType::EXACT) {
+                return {tt_score, tt_move};
+            } else if (tt_type == transposition::NodeType::ALPHA && tt_score <= alpha) {
+                return {alpha, tt_move};
+            } else if (tt_type == transposition::NodeType::BETA && tt_score >= beta) {
+                return {beta, tt_move};
+            }
         }
     }
 
-    // Base case: If the game is over or max depth is reached, return evaluation
-    if (game_state.is_game_over()) {
-        return {evaluate::evaluate(color, game_state) * (depth + 1), moves::Move()};
+    if (ply > 0) {
+        if (game_state.is_draw_by_fifty_move_rule()) {
+            return {0, moves::Move()};
+        }
+
+        // Mate distance pruning: no line from here can beat a mate already found closer to the root
+        alpha = std::max(alpha, -evaluate::MATE_SCORE + ply);
+        beta = std::min(beta, evaluate::MATE_SCORE - ply - 1);
+        if (alpha >= beta) {
+            return {alpha, moves::Move()};
+        }
+    }
+
+    // Tablebase hit: a win is a lower bound and a loss an upper bound, since a faster mate may exist
+    tablebase::Wdl wdl;
+    if (ply > 0 && tablebase::probe_wdl(game_state, wdl)) {
+        ++ctx.tb_hits;
+        int score = tablebase_score(wdl, ply);
+        transposition::NodeType bound = (wdl == tablebase::Wdl::WIN)    ? transposition::NodeType::BETA
+                                        : (wdl == tablebase::Wdl::LOSS) ? transposition::NodeType::ALPHA
+                                                                        : transposition::NodeType::EXACT;
+        if (bound == transposition::NodeType::EXACT ||
+            (bound == transposition::NodeType::BETA && score >= beta) ||
+            (bound == transposition::NodeType::ALPHA && score <= alpha)) {
+            ctx.table->store(hash, std::min(depth + TB_DEPTH_BONUS, MAX_DEPTH), evaluate::score_to_tt(score, ply), bound, moves::Move());
+            return {score, moves::Move()};
+        }
     }
 
+    // Quiescence search detects mate itself while evading check
     if (depth == 0) {
-        return {evaluate::evaluate(color, game_state), moves::Move()};
+        return {evaluate::quiescence(alpha, beta, color, game_state, ctx, ply), moves::Move()};
     }
 
+    int original_alpha = alpha;
     int max_eval = NEG_INF;
     moves::Move best_move;
-    std::vector<moves::Move> possible_moves = order::order_moves(moves::generate_legal_moves(color, game_state), game_state);
+    std::vector<moves::Move> possible_moves = moves::generate_legal_moves(color, game_state);
+
+    // No legal moves: checkmate, scored by its distance from the root so shorter mates are preferred, or stalemate
+    if (possible_moves.empty()) {
+        int score = game_state.is_in_check(color) ? -evaluate::MATE_SCORE + ply : 0;
+        if (!partial_root) {
+            ctx.table->store(hash, depth, evaluate::score_to_tt(score, ply), transposition::NodeType::EXACT, moves::Move());
+        }
+        return {score, moves::Move()};
+    }
+
+    possible_moves = order::order_moves(possible_moves, game_state, &ctx.state->heuristics, ply);
+    if (partial_root) {
+        const std::vector<moves::Move> &excluded = ctx.excluded_root_moves;
+        possible_moves.erase(std::remove_if(possible_moves.begin(), possible_moves.end(), [&excluded](const moves::Move &move) {
+                                 return std::find(excluded.begin(), excluded.end(), move) != excluded.end();
+                             }),
+                             possible_moves.end());
+        if (possible_moves.empty()) {
+            return {NEG_INF, moves::Move()};
+        }
+    }
 
     // Use the TT move if available
     if (!tt_move.is_null()) {
@@ -62,25 +252,55 @@ std::pair<int, moves::Move> negamax(int depth, int alpha, int beta, piece::Color
         }
     }
 
+    // Along the previous iteration's PV, its move goes first even ahead of the TT move
+    if (ctx.follow_pv) {
+        auto it = possible_moves.end();
+        if (ply < static_cast<int>(ctx.previous_pv.size())) {
+            it = std::find(possible_moves.begin(), possible_moves.end(), ctx.previous_pv[ply]);
+        }
+        if (it != possible_moves.end()) {
+            std::rotate(possible_moves.begin(), it, it + 1);
+        } else {
+            ctx.follow_pv = false;
+        }
+    }
+
+    ctx.state->key_history.push_back(hash);
     for (const auto &move : possible_moves) {
+        // The child probes its table slot first thing; start loading it while the move is made
+        ctx.table->prefetch(zobrist::hash_after(hash, move, game_state));
         game_state.make_move(move);
-        int eval = -negamax(depth - 1, -beta, -alpha, utils::opposite_color(color), game_state).first;
+        int eval = -negamax(depth - 1, -beta, -alpha, utils::opposite_color(color), game_state, ctx).first;
         game_state.unmake_move();
 
+        // Only the first path searched can be the previous PV
+        ctx.follow_pv = false;
+
+        // An interrupted subtree has no meaningful score; keep only what was fully searched
+        if (ctx.stopped) {
+            ctx.state->key_history.pop_back();
+            return {max_eval, best_move};
+        }
+
         if (eval > max_eval) {
             max_eval = eval;
             best_move = move;
+            ctx.pv_table->update(ply, move);
         }
 
         alpha = std::max(alpha, eval);
         if (alpha >= beta) {
+            if (order::is_quiet(move)) {
+                ctx.state->heuristics.record_cutoff(move, ply, depth);
+            }
             break;
         }
     }
+    ctx.state->key_history.pop_back();
 
     // Store the result in the transposition table
     transposition::NodeType node_type;
-    if (max_eval <= alpha) {
+    if (max_eval <= original_alpha) {
         node_type = transposition::NodeType::ALPHA;
     } else if (max_eval >= beta) {
         node_type = transposition::NodeType::BETA;
@@ -88,35 +308,281 @@ std::pair<int, moves::Move> negamax(int depth, int alpha, int beta, piece::Color
         node_type = transposition::NodeType::EXACT;
     }
 
-    uint64_t tt_hash = hash;
-    int tt_depth = depth;
-    int tt_max_eval = max_eval;
-    transposition::NodeType tt_node_type = node_type;
-    moves::Move tt_best_move = best_move;
+    if (!partial_root) {
+        ctx.table->store(hash, depth, evaluate::score_to_tt(max_eval, ply), node_type, best_move);
+    }
 
-    // std::cout << "Hash: " << tt_hash << " - ";
-    // std::cout << moves::to_string(tt_best_move) << std::endl;
+    return {max_eval, best_move};
+}
 
-    tt.store(tt_hash, tt_depth, tt_max_eval, tt_node_type, tt_best_move);
+std::vector<moves::Move> extract_pv(game_state::GameState &game_state, int max_length, transposition::TranspositionTable &table) {
+    std::vector<moves::Move> pv;
+    size_t history_size = game_state.move_history.size();
 
-    return {max_eval, best_move};
+    // Follow the best moves stored in the transposition table, checking each one for legality
+    while (static_cast<int>(pv.size()) < max_length) {
+        int tt_score;
+        transposition::NodeType tt_type;
+        moves::Move tt_move;
+        if (!table.probe(zobrist::compute_hash(game_state), 0, tt_score, tt_type, tt_move) || tt_move.is_null()) {
+            break;
+        }
+
+        std::vector<moves::Move> legal_moves = moves::generate_legal_moves(game_state.turn, game_state);
+        auto it = std::find(legal_moves.begin(), legal_moves.end(), tt_move);
+        if (it == legal_moves.end() || !game_state.make_move(*it)) {
+            break;
+        }
+        pv.push_back(*it);
+    }
+
+    while (game_state.move_history.size() > history_size) {
+        game_state.unmake_move();
+    }
+
+    return pv;
+}
+
+// Add the work done since the last call to this thread's cumulative counters. Only the main
+// thread of a search adds its time, so nodes over time stays the real throughput with helpers.
+void publish_counters(const SearchContext &ctx, SearchContext &published, bool helper) {
+    statistics::ThreadCounters &counters = statistics::local_counters();
+    auto now = std::chrono::steady_clock::now();
+
+    statistics::add(counters.nodes, ctx.nodes - published.nodes);
+    statistics::add(counters.qnodes, ctx.qnodes - published.qnodes);
+    statistics::add(counters.tt_probes, ctx.tt_probes - published.tt_probes);
+    statistics::add(counters.tt_hits, ctx.tt_hits - published.tt_hits);
+    statistics::add(counters.tb_hits, ctx.tb_hits - published.tb_hits);
+    if (!helper) {
+        statistics::add(counters.search_time_us, std::chrono::duration_cast<std::chrono::microseconds>(now - published.start_time).count());
+    }
+
+    published = ctx;
+    published.start_time = now;
+}
+
+void check_limits(SearchContext &ctx) {
+    auto now = std::chrono::steady_clock::now();
+    if ((ctx.token != nullptr && ctx.token->is_expired(now)) ||
+        (ctx.node_limit != 0 && ctx.nodes >= ctx.node_limit) ||
+        now >= ctx.deadline ||
+        (ctx.table == &tt && tt_quiesce.load(std::memory_order_relaxed))) {
+        ctx.stopped = true;
+    }
+}
+
+moves::Move iterative_deepening(const SearchLimits &limits, piece::Color color, game_state::GameState &game_state,
+                                const InfoCallback &on_info, const CancellationToken *token, SearchState &state,
+                                bool helper) {
+    SearchContext ctx;
+    ctx.state = &state;
+    ctx.table = (state.table != nullptr) ? state.table : &tt;
+    ctx.root_ply = state.key_history.size();
+    ctx.deadline = limits.deadline;
+    if (limits.movetime_ms > 0) {
+        ctx.deadline = std::min(ctx.deadline, ctx.start_time + std::chrono::milliseconds(limits.movetime_ms));
+    }
+    ctx.node_limit = limits.nodes;
+    ctx.token = token;
+
+    PvTable pv_table;
+    ctx.pv_table = &pv_table;
+
+    SearchContext published = ctx;
+    moves::Move best_move;
+    std::vector<std::vector<moves::Move>> previous_lines;
+
+    // Iterative deepening: each iteration seeds the transposition table for the next one
+    int max_depth = std::min(std::max(limits.depth, 1), MAX_DEPTH);
+    int lines = std::min(std::max(limits.multipv, 1), MAX_MULTIPV);
+    bool mate_found = false;
+    for (int current_depth = 1; current_depth <= max_depth && !ctx.stopped && !mate_found; ++current_depth) {
+        // MultiPV: each pass finds the best root move not reported by the earlier ones
+        ctx.excluded_root_moves.clear();
+        std::vector<SearchInfo> depth_lines;
+        for (int line = 1; line <= lines; ++line) {
+            // Seed move ordering with this line's PV from the previous iteration
+            ctx.previous_pv = (line <= static_cast<int>(previous_lines.size())) ? previous_lines[line - 1] : std::vector<moves::Move>();
+            ctx.follow_pv = !ctx.previous_pv.empty();
+
+            std::pair<int, moves::Move> result = negamax(current_depth, NEG_INF, INF, color, game_state, ctx);
+
+            // Publishing once per pass keeps the per-node cost to plain increments on ctx
+            publish_counters(ctx, published, helper);
+
+            // A stopped iteration is incomplete, so its move only counts if nothing better exists
+            if (ctx.stopped) {
+                if (best_move.is_null() && line == 1) {
+                    best_move = result.second;
+                }
+                break;
+            }
+
+            // Fewer legal moves than requested lines
+            if (result.second.is_null()) {
+                break;
+            }
+
+            if (line == 1) {
+                best_move = result.second;
+
+                // A full-width search to this depth already sees every shorter mate, so deeper ones cannot change it
+                mate_found = lines == 1 && evaluate::is_mate_score(result.first) &&
+                             evaluate::MATE_SCORE - std::abs(result.first) <= current_depth;
+            }
+            ctx.excluded_root_moves.push_back(result.second);
+
+            // The collected PV ends early below TT cutoffs; the TT walk fills in the rest
+            std::vector<moves::Move> pv = pv_table.line(0);
+            if (pv.empty() || pv.front() != result.second) {
+                pv.assign(1, result.second);
+            }
+            for (const auto &move : pv) {
+                game_state.make_move(move);
+            }
+            std::vector<moves::Move> continuation = extract_pv(game_state, current_depth - static_cast<int>(pv.size()), *ctx.table);
+            for (size_t i = 0; i < pv.size(); ++i) {
+                game_state.unmake_move();
+            }
+            pv.insert(pv.end(), continuation.begin(), continuation.end());
+
+            SearchInfo info;
+            info.depth = current_depth;
+            info.score = result.first;
+            info.pv = pv;
+            depth_lines.push_back(info);
+        }
+
+        if (depth_lines.empty()) {
+            continue;
+        }
+
+        // A later pass can outscore an earlier one through TT entries it did not see, so lines are ranked by score
+        std::stable_sort(depth_lines.begin(), depth_lines.end(),
+                         [](const SearchInfo &a, const SearchInfo &b) { return a.score > b.score; });
+        best_move = depth_lines.front().pv.front();
+
+        previous_lines.resize(std::max(previous_lines.size(), depth_lines.size()));
+        for (size_t i = 0; i < depth_lines.size(); ++i) {
+            previous_lines[i] = depth_lines[i].pv;
+        }
+
+        if (on_info) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - ctx.start_time);
+
+            for (size_t i = 0; i < depth_lines.size(); ++i) {
+                SearchInfo &info = depth_lines[i];
+                info.multipv = static_cast<int>(i) + 1;
+                info.nodes = ctx.nodes;
+                info.time_ms = elapsed.count();
+                info.nps = ctx.nodes * 1000 / std::max<int64_t>(1, elapsed.count());
+                info.hashfull = ctx.table->hashfull();
+                info.tbhits = ctx.tb_hits;
+                on_info(info);
+            }
+        }
+    }
+
+    // Stopped before a single root move was searched: still return something playable
+    if (best_move.is_null()) {
+        std::vector<moves::Move> legal_moves = moves::generate_legal_moves(color, game_state);
+        if (!legal_moves.empty()) {
+            best_move = legal_moves.front();
+        }
+    }
+
+    return best_move;
+}
+
+moves::Move find_best_move(const SearchLimits &limits, piece::Color color, game_state::GameState &game_state,
+                           const InfoCallback &on_info, const CancellationToken *token, SearchState *state) {
+    SearchState local_state;
+    if (state == nullptr) {
+        state = &local_state;
+    }
+
+    // Killers are stored by ply from the root, which moved forward since the last search of this game
+    state->heuristics.advance(static_cast<int>(state->key_history.size()) - static_cast<int>(state->last_root_ply));
+    state->last_root_ply = state->key_history.size();
+
+    transposition::TranspositionTable *table = (state->table != nullptr) ? state->table : &tt;
+    TableUse table_use(table);
+    table->new_search();
+
+    // A tablebase position at the root needs no search: play the move that keeps its result
+    // and reaches a capture or pawn move soonest
+    moves::Move tablebase_move;
+    tablebase::Wdl root_wdl;
+    if (limits.multipv <= 1 && tablebase::probe_root(game_state, tablebase_move, root_wdl)) {
+        statistics::add(statistics::local_counters().tb_hits, 1);
+        if (on_info) {
+            SearchInfo info;
+            info.depth = 1;
+            info.score = tablebase_score(root_wdl, 0);
+            info.nodes = 1;
+            info.tbhits = 1;
+            info.pv.push_back(tablebase_move);
+            on_info(info);
+        }
+        return tablebase_move;
+    }
+
+    ActiveSearch active_search;
+    if (thread_count <= 1) {
+        return iterative_deepening(limits, color, game_state, on_info, token, *state, false);
+    }
+
+    // Lazy SMP: helpers search private copies of the position without a depth or node limit
+    // and are stopped as soon as the main search is done
+    SearchLimits helper_limits = limits;
+    helper_limits.depth = MAX_DEPTH;
+    helper_limits.nodes = 0;
+    helper_limits.multipv = 1;
+
+    CancellationToken helpers_token;
+    std::vector<game_state::GameState> helper_states(thread_count - 1, game_state);
+    std::vector<SearchState> helper_search_states(thread_count - 1, *state);
+    std::vector<std::thread> helpers;
+    for (int i = 0; i < thread_count - 1; ++i) {
+        helpers.emplace_back([&helper_limits, &helpers_token, &helper_states, &helper_search_states, color, i]() {
+            iterative_deepening(helper_limits, color, helper_states[i], nullptr, &helpers_token, helper_search_states[i], true);
+        });
+    }
+
+    moves::Move best_move = iterative_deepening(limits, color, game_state, on_info, token, *state, false);
+
+    helpers_token.cancel();
+    for (auto &helper : helpers) {
+        helper.join();
+    }
+
+    return best_move;
 }
 
-moves::Move find_best_move(int depth, piece::Color color, game_state::GameState &game_state) {
-    // Find the best move using negamax with alpha-beta pruning
-    std::pair<int, moves::Move> result = negamax(depth, NEG_INF, INF, color, game_state);
-    return result.second;
+moves::Move find_best_move(int depth, piece::Color color, game_state::GameState &game_state, const InfoCallback &on_info) {
+    SearchLimits limits;
+    limits.depth = depth;
+    return find_best_move(limits, color, game_state, on_info);
 }
 
-moves::Move calculate_best_move(const std::string &fen) {
+moves::Move calculate_best_move(const std::string &fen, const SearchLimits &limits,
+                                const InfoCallback &on_info, const CancellationToken *token) {
     // Initialize a board with the given FEN
     game_state::GameState state = game_state::set_game_state(fen);
 
+    // Opening positions are answered from the book, when one is open, without searching
+    moves::Move book_move;
+    if (limits.multipv <= 1 && book::probe(state, book_move)) {
+        return book_move;
+    }
+
     // Use the search algorithm to find the best move
-    moves::Move best_move = find_best_move(4, state.turn, state);
+    return find_best_move(limits, state.turn, state, on_info, token);
+}
 
-    // Convert the best move to a string (e.g., e2e4)
-    return best_move;
+moves::Move calculate_best_move(const std::string &fen, const InfoCallback &on_info) {
+    return calculate_best_move(fen, SearchLimits(), on_info);
 }
 
 } // namespace search
@@ -6,15 +6,195 @@
 #include "../structure/board.h"
 #include "../structure/game_state.h"
 #include "../structure/square.h"
+#include "order.h"
+#include "transposition.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
 
 namespace chess_engine {
 namespace search {
 
-moves::Move find_best_move(int depth, piece::Color color, game_state::GameState &game_state);
+constexpr int INF = std::numeric_limits<int>::max();
+constexpr int NEG_INF = -INF; // Symmetric bound so that negating it cannot overflow
 
-moves::Move calculate_best_move(const std::string &fen);
+constexpr int DEFAULT_DEPTH = 4; // Depth used when a request does not ask for one
+constexpr int MAX_DEPTH = 64;
+constexpr int MAX_MULTIPV = 10;
+
+// Tablebase results are exact, so their TT entries claim this much more depth than the node had
+constexpr int TB_DEPTH_BONUS = 6;
+
+// Limits are polled every NODE_CHECK_INTERVAL nodes (must be a power of two)
+constexpr uint64_t NODE_CHECK_INTERVAL = 1024;
+
+// Per-request limits, any of which ends the search. Zero means no limit.
+struct SearchLimits {
+    int depth = DEFAULT_DEPTH;
+    int64_t movetime_ms = 0;
+    uint64_t nodes = 0;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    int multipv = 1; // Number of best root moves to report, each with its own score and PV
+};
+
+// Lets another thread stop a running search, either right away or at a deadline set while
+// it runs (e.g. on a ponder hit). The search returns the best move found so far.
+class CancellationToken {
+  public:
+    void cancel() {
+        cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    bool is_cancelled() const {
+        return cancelled.load(std::memory_order_relaxed);
+    }
+
+    void set_deadline(std::chrono::steady_clock::time_point time) {
+        deadline.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    bool is_expired(std::chrono::steady_clock::time_point now) const {
+        return is_cancelled() || now.time_since_epoch().count() >= deadline.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<bool> cancelled{false};
+    std::atomic<std::chrono::steady_clock::rep> deadline{std::chrono::steady_clock::time_point::max().time_since_epoch().count()};
+};
+
+// Shared by every search (defined in search.cpp)
+extern transposition::TranspositionTable tt;
+
+// Threads used by each search (Lazy SMP); helpers share results only through the TT
+extern int thread_count;
+
+// Resize or clear tt from any thread. Searches running on it stop early with their best move so
+// far, searches starting meanwhile wait, and the table is reallocated and zeroed by its init
+// threads before they resume. A resize that cannot be allocated throws std::bad_alloc and
+// leaves the table as it was.
+void resize_tt(size_t size_mb);
+void clear_tt();
+
+// Write tt to a snapshot file, stopping running searches the same way. Returns false if the
+// file cannot be written.
+bool save_tt(const std::string &path);
+
+// Progress report emitted after every completed iteration of iterative deepening
+struct SearchInfo {
+    int depth = 0;
+    int multipv = 1; // Rank of this line among the root moves, 1 being the best
+    int score = 0;
+    uint64_t nodes = 0;
+    uint64_t nps = 0;
+    int64_t time_ms = 0;
+    int hashfull = 0; // Permille of the transposition table in use
+    uint64_t tbhits = 0;
+    std::vector<moves::Move> pv;
+};
+
+using InfoCallback = std::function<void(const SearchInfo &)>;
+
+// What one search of a game leaves for the next: the keys of the positions played so far
+// (for repetition detection) and the move-ordering tables
+struct SearchState {
+    std::vector<uint64_t> key_history; // Zobrist keys of the earlier positions, oldest first
+    order::Heuristics heuristics;
+    size_t last_root_ply = 0; // key_history size at the previous search
+
+    // Table of this game's searches; null shares the global tt
+    transposition::TranspositionTable *table = nullptr;
+
+    // Record the current position before a move is played from it
+    void push_position(const game_state::GameState &game_state);
+};
+
+// Triangular PV table: row N holds the best line found from ply N of the current path,
+// built bottom-up as each node adopts its best child's row behind its own move
+class PvTable {
+  public:
+    PvTable() : table((MAX_DEPTH + 1) * (MAX_DEPTH + 1)), length(MAX_DEPTH + 2, 0) {}
+
+    void clear(int ply) {
+        length[ply] = 0;
+    }
+
+    void update(int ply, const moves::Move &move) {
+        moves::Move *row = &table[ply * (MAX_DEPTH + 1)];
+        const moves::Move *child_row = row + (MAX_DEPTH + 1);
+        int child_length = (ply < MAX_DEPTH) ? length[ply + 1] : 0;
+
+        row[0] = move;
+        std::copy(child_row, child_row + child_length, row + 1);
+        length[ply] = child_length + 1;
+    }
+
+    std::vector<moves::Move> line(int ply) const {
+        const moves::Move *row = &table[ply * (MAX_DEPTH + 1)];
+        return std::vector<moves::Move>(row, row + length[ply]);
+    }
+
+  private:
+    std::vector<moves::Move> table;
+    std::vector<int> length;
+};
+
+// State shared by every node of a single search
+struct SearchContext {
+    uint64_t nodes = 0;
+    uint64_t qnodes = 0; // Subset of nodes visited by quiescence search
+    uint64_t tt_probes = 0;
+    uint64_t tt_hits = 0;
+    uint64_t tb_hits = 0; // Tablebase probes that returned a result
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    // Stop conditions, resolved from SearchLimits when the search starts
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    uint64_t node_limit = 0;
+    const CancellationToken *token = nullptr;
+    bool stopped = false;
+
+    SearchState *state = nullptr;                   // Never null during a search
+    transposition::TranspositionTable *table = &tt; // The state's table, or the global one
+    size_t root_ply = 0;          // key_history size at the root
+
+    // MultiPV: root moves already reported in this iteration, skipped by the next pass
+    std::vector<moves::Move> excluded_root_moves;
+
+    PvTable *pv_table = nullptr;          // Never null during a search
+    std::vector<moves::Move> previous_pv; // Searched first, ply by ply, while follow_pv holds
+    bool follow_pv = false;               // The current path is a prefix of previous_pv
+};
+
+void check_limits(SearchContext &ctx);
+
+// Cheap test for the hot path; the limits themselves are only checked every NODE_CHECK_INTERVAL nodes
+inline bool should_stop(SearchContext &ctx) {
+    if (!ctx.stopped && (ctx.nodes & (NODE_CHECK_INTERVAL - 1)) == 0) {
+        check_limits(ctx);
+    }
+    return ctx.stopped;
+}
+
+std::vector<moves::Move> extract_pv(game_state::GameState &game_state, int max_length, transposition::TranspositionTable &table = tt);
+
+// Pass a SearchState to carry repetition history and move-ordering tables across the searches of a game
+moves::Move find_best_move(const SearchLimits &limits, piece::Color color, game_state::GameState &game_state,
+                           const InfoCallback &on_info = nullptr, const CancellationToken *token = nullptr,
+                           SearchState *state = nullptr);
+
+moves::Move find_best_move(int depth, piece::Color color, game_state::GameState &game_state, const InfoCallback &on_info = nullptr);
+
+moves::Move calculate_best_move(const std::string &fen, const SearchLimits &limits,
+                                const InfoCallback &on_info = nullptr, const CancellationToken *token = nullptr);
+
+moves::Move calculate_best_move(const std::string &fen, const InfoCallback &on_info = nullptr);
 
 } // namespace search
 } // namespace chess_engine
 
-#endif
\ No newline at end of file
+#endif
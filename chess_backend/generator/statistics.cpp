@@ -0,0 +1,73 @@
+#include "statistics.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace chess_engine {
+namespace statistics {
+
+namespace {
+
+std::mutex registry_mutex;
+std::vector<ThreadCounters *> live_counters; // Counters of threads that are still running
+Totals retired_totals;                       // Counters folded in from threads that have exited
+std::atomic<int> active_searches{0};
+
+void accumulate(Totals &totals, const ThreadCounters &counters) {
+    totals.nodes += counters.nodes.load(std::memory_order_relaxed);
+    totals.qnodes += counters.qnodes.load(std::memory_order_relaxed);
+    totals.tt_probes += counters.tt_probes.load(std::memory_order_relaxed);
+    totals.tt_hits += counters.tt_hits.load(std::memory_order_relaxed);
+    totals.tb_hits += counters.tb_hits.load(std::memory_order_relaxed);
+    totals.book_probes += counters.book_probes.load(std::memory_order_relaxed);
+    totals.book_hits += counters.book_hits.load(std::memory_order_relaxed);
+    totals.searches += counters.searches.load(std::memory_order_relaxed);
+    totals.search_time_us += counters.search_time_us.load(std::memory_order_relaxed);
+}
+
+// Registers the owning thread's counters and folds them into the retired totals on thread exit
+struct Registration {
+    ThreadCounters counters;
+
+    Registration() {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        live_counters.push_back(&counters);
+    }
+
+    ~Registration() {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        accumulate(retired_totals, counters);
+        live_counters.erase(std::remove(live_counters.begin(), live_counters.end(), &counters), live_counters.end());
+    }
+};
+
+} // namespace
+
+ThreadCounters &local_counters() {
+    thread_local Registration registration;
+    return registration.counters;
+}
+
+Totals aggregate() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    Totals totals = retired_totals;
+    for (const ThreadCounters *counters : live_counters) {
+        accumulate(totals, *counters);
+    }
+    totals.active_searches = active_searches.load(std::memory_order_relaxed);
+
+    return totals;
+}
+
+void search_started() {
+    active_searches.fetch_add(1, std::memory_order_relaxed);
+}
+
+void search_finished() {
+    active_searches.fetch_sub(1, std::memory_order_relaxed);
+}
+
+} // namespace statistics
+} // namespace chess_engine
@@ -0,0 +1,56 @@
+#ifndef CHESS_ENGINE_STATISTICS_H
+#define CHESS_ENGINE_STATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace chess_engine {
+namespace statistics {
+
+// Cumulative search counters. Each thread owns one instance and is the only writer,
+// so publishing is a plain relaxed load/store with no shared cache line contention.
+struct ThreadCounters {
+    std::atomic<uint64_t> nodes{0};
+    std::atomic<uint64_t> qnodes{0};
+    std::atomic<uint64_t> tt_probes{0};
+    std::atomic<uint64_t> tt_hits{0};
+    std::atomic<uint64_t> tb_hits{0};
+    std::atomic<uint64_t> book_probes{0};
+    std::atomic<uint64_t> book_hits{0};
+    std::atomic<uint64_t> searches{0};
+    std::atomic<uint64_t> search_time_us{0};
+};
+
+// Snapshot of all counters, summed over live and finished threads
+struct Totals {
+    uint64_t nodes = 0;
+    uint64_t qnodes = 0;
+    uint64_t tt_probes = 0;
+    uint64_t tt_hits = 0;
+    uint64_t tb_hits = 0;
+    uint64_t book_probes = 0;
+    uint64_t book_hits = 0;
+    uint64_t searches = 0;
+    uint64_t search_time_us = 0;
+    int active_searches = 0;
+};
+
+// Counters of the calling thread, registered for aggregation on first use
+ThreadCounters &local_counters();
+
+// Add to a counter owned by the calling thread
+inline void add(std::atomic<uint64_t> &counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// Aggregate every thread's counters; only called when metrics are scraped
+Totals aggregate();
+
+// Tracks the number of searches currently running
+void search_started();
+void search_finished();
+
+} // namespace statistics
+} // namespace chess_engine
+
+#endif
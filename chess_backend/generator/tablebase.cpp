@@ -0,0 +1,132 @@
+#include "tablebase.h"
+#include "../enums.h"
+#include <algorithm>
+#include <mutex>
+
+#ifdef CHESS_ENGINE_SYZYGY
+#include "tbprobe.h"
+#endif
+
+namespace chess_engine {
+namespace tablebase {
+
+#ifdef CHESS_ENGINE_SYZYGY
+
+bool init(const std::string &path) {
+    if (path.empty()) {
+        tb_free();
+        return false;
+    }
+    return tb_init(path.c_str()) && TB_LARGEST > 0;
+}
+
+int max_pieces() {
+    return static_cast<int>(TB_LARGEST);
+}
+
+// Arguments shared by every Fathom probe, in its square numbering (a1 = 0, as ours)
+struct ProbePosition {
+    uint64_t white, black, kings, queens, rooks, bishops, knights, pawns;
+    unsigned ep;
+    bool white_to_move;
+};
+
+ProbePosition to_probe_position(const game_state::GameState &state) {
+    const board::Board &board = state.get_board();
+    ProbePosition position;
+    position.white = board.get_white_pieces();
+    position.black = board.get_black_pieces();
+    position.kings = board.get_king(piece::Color::WHITE) | board.get_king(piece::Color::BLACK);
+    position.queens = board.get_queens(piece::Color::WHITE) | board.get_queens(piece::Color::BLACK);
+    position.rooks = board.get_rooks(piece::Color::WHITE) | board.get_rooks(piece::Color::BLACK);
+    position.bishops = board.get_bishops(piece::Color::WHITE) | board.get_bishops(piece::Color::BLACK);
+    position.knights = board.get_knights(piece::Color::WHITE) | board.get_knights(piece::Color::BLACK);
+    position.pawns = board.get_pawns(piece::Color::WHITE) | board.get_pawns(piece::Color::BLACK);
+    position.ep = (state.en_passant_square != -1) ? static_cast<unsigned>(state.en_passant_square) : 0;
+    position.white_to_move = state.turn == piece::Color::WHITE;
+    return position;
+}
+
+bool probe_wdl(const game_state::GameState &state, Wdl &wdl) {
+    if (state.halfmove_clock != 0 || !probeable(state)) {
+        return false;
+    }
+
+    ProbePosition p = to_probe_position(state);
+    unsigned result = tb_probe_wdl(p.white, p.black, p.kings, p.queens, p.rooks, p.bishops, p.knights, p.pawns,
+                                   0, 0, p.ep, p.white_to_move);
+    if (result == TB_RESULT_FAILED) {
+        return false;
+    }
+    wdl = static_cast<Wdl>(result);
+    return true;
+}
+
+bool probe_root(game_state::GameState &state, moves::Move &move, Wdl &wdl) {
+    if (!probeable(state)) {
+        return false;
+    }
+
+    // Fathom's root probe is not thread-safe, and every server connection can search at once
+    static std::mutex root_probe_mutex;
+    ProbePosition p = to_probe_position(state);
+    unsigned result;
+    {
+        std::lock_guard<std::mutex> lock(root_probe_mutex);
+        result = tb_probe_root(p.white, p.black, p.kings, p.queens, p.rooks, p.bishops, p.knights, p.pawns,
+                               static_cast<unsigned>(state.halfmove_clock), 0, p.ep, p.white_to_move, nullptr);
+    }
+    if (result == TB_RESULT_FAILED || result == TB_RESULT_CHECKMATE || result == TB_RESULT_STALEMATE) {
+        return false;
+    }
+
+    static const piece::Type promotions[] = {piece::Type::EMPTY, piece::Type::QUEEN, piece::Type::ROOK,
+                                             piece::Type::BISHOP, piece::Type::KNIGHT};
+    int from = static_cast<int>(TB_GET_FROM(result));
+    int to = static_cast<int>(TB_GET_TO(result));
+    piece::Type promotion = promotions[TB_GET_PROMOTES(result)];
+
+    for (const auto &candidate : moves::generate_legal_moves(state.turn, state)) {
+        if (candidate.from == from && candidate.to == to && candidate.promotion == promotion) {
+            move = candidate;
+            break;
+        }
+    }
+    if (move.is_null()) {
+        return false;
+    }
+
+    wdl = static_cast<Wdl>(TB_GET_WDL(result));
+    return true;
+}
+
+#else
+
+bool init(const std::string &) {
+    return false;
+}
+
+int max_pieces() {
+    return 0;
+}
+
+bool probe_wdl(const game_state::GameState &, Wdl &) {
+    return false;
+}
+
+bool probe_root(game_state::GameState &, moves::Move &, Wdl &) {
+    return false;
+}
+
+#endif
+
+bool probeable(const game_state::GameState &state) {
+    const board::Board &board = state.get_board();
+    return max_pieces() > 0 &&
+           __builtin_popcountll(board.get_occupied_squares()) <= max_pieces() &&
+           !state.white_castle_kingside && !state.white_castle_queenside &&
+           !state.black_castle_kingside && !state.black_castle_queenside;
+}
+
+} // namespace tablebase
+} // namespace chess_engine
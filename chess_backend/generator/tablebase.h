@@ -0,0 +1,44 @@
+#ifndef CHESS_ENGINE_TABLEBASE_H
+#define CHESS_ENGINE_TABLEBASE_H
+
+#include "../moves/moves.h"
+#include "../structure/game_state.h"
+#include <string>
+
+namespace chess_engine {
+namespace tablebase {
+
+// Win/draw/loss for the side to move. Cursed wins and blessed losses are decisive only
+// without the fifty-move rule.
+enum class Wdl {
+    LOSS,
+    BLESSED_LOSS,
+    DRAW,
+    CURSED_WIN,
+    WIN
+};
+
+// Open the Syzygy tables (.rtbw/.rtbz) under the directories of a path list separated by
+// ':' (';' on Windows). Tables are memory-mapped on first probe. An empty path closes them.
+// Must not be called while a search is running. Returns false if none were found or the
+// engine was built without tablebase support.
+bool init(const std::string &path);
+
+// Most pieces, kings included, of any table found; 0 when probing is off
+int max_pieces();
+
+// Whether a position can be probed at all: few enough pieces and no castling rights
+bool probeable(const game_state::GameState &state);
+
+// Result with best play, counting the fifty-move rule. Only valid right after a capture or pawn
+// move (zero halfmove clock), which is the only time the WDL tables are exact.
+bool probe_wdl(const game_state::GameState &state, Wdl &wdl);
+
+// The move that keeps the root result with the shortest distance to a zeroing move (DTZ),
+// which respects the fifty-move rule from any halfmove clock
+bool probe_root(game_state::GameState &state, moves::Move &move, Wdl &wdl);
+
+} // namespace tablebase
+} // namespace chess_engine
+
+#endif
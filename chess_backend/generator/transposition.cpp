@@ -1,55 +1,311 @@
 #include "transposition.h"
 #include "../enums.h"
+#include "evaluate.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sys/mman.h>
+#include <thread>
 #include <vector>
 
 namespace chess_engine {
 namespace transposition {
 
-TranspositionTable::TranspositionTable(size_t size_mb) {
-    size = (size_mb * 1024 * 1024) / sizeof(TTEntry);
-    table.resize(size);
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+const char *page_mode_name(PageMode mode) {
+    switch (mode) {
+    case PageMode::HUGETLB:
+        return "hugetlb";
+    case PageMode::TRANSPARENT:
+        return "transparent";
+    default:
+        return "normal";
+    }
+}
+
+TranspositionTable::TranspositionTable(size_t size_mb, PageMode pages) : requested_pages(pages) {
+    allocate(size_mb);
     clear();
 }
 
-TranspositionTable::~TranspositionTable() {}
+TranspositionTable::~TranspositionTable() {
+    release();
+}
+
+// Map the table with the largest pages available, without touching it: pages are only
+// committed by clear(), on the node of the thread that zeroes them. The old table is only
+// released once the new one is mapped; if mapping fails, it is kept and bad_alloc thrown.
+void TranspositionTable::allocate(size_t size_mb) {
+    size_t new_size = std::max<size_t>(1, (size_mb * 1024 * 1024) / sizeof(TTEntry));
+    size_t new_bytes = (new_size * sizeof(TTEntry) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+    void *memory = MAP_FAILED;
+    PageMode new_pages = PageMode::NORMAL;
+    if (requested_pages == PageMode::HUGETLB) {
+        memory = mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        new_pages = PageMode::HUGETLB;
+    }
+    if (memory == MAP_FAILED) {
+        memory = mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        new_pages = PageMode::NORMAL;
+        if (memory != MAP_FAILED && requested_pages != PageMode::NORMAL && madvise(memory, new_bytes, MADV_HUGEPAGE) == 0) {
+            new_pages = PageMode::TRANSPARENT;
+        }
+    }
+    if (memory == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+
+    release();
+    table = static_cast<TTEntry *>(memory);
+    size = new_size;
+    mapped_bytes = new_bytes;
+    pages = new_pages;
+}
+
+void TranspositionTable::release() {
+    if (table != nullptr) {
+        munmap(table, mapped_bytes);
+    }
+    table = nullptr;
+    size = 0;
+    mapped_bytes = 0;
+}
+
+PageMode TranspositionTable::page_mode() const {
+    return pages;
+}
+
+void TranspositionTable::set_init_threads(int threads) {
+    init_threads = std::max(1, threads);
+}
+
+// Layout of TTEntry::data, from the low bits up:
+//   score       25 bits, signed (mate scores reach MATE_SCORE + MAX_MATE_PLY)
+//   best move   22 bits: from 6, to 6, piece type 3, color 1, move type 3, promotion 3
+//               (no move is stored as piece type EMPTY)
+//   node type    2 bits
+//   depth        7 bits, stored plus one so that empty slots have depth -1
+//   generation   8 bits
+constexpr int SCORE_BITS = 25;
+constexpr int MOVE_SHIFT = 25;
+constexpr int TYPE_SHIFT = 47;
+constexpr int DEPTH_SHIFT = 49;
+constexpr int GENERATION_SHIFT = 56;
+
+static_assert(evaluate::MATE_SCORE + evaluate::MAX_MATE_PLY < (1 << (SCORE_BITS - 1)), "scores must fit the entry");
+static_assert(search::MAX_DEPTH + 1 < (1 << (GENERATION_SHIFT - DEPTH_SHIFT)), "depths must fit the entry");
+
+uint64_t pack_move(const moves::Move &move) {
+    if (move.is_null()) {
+        return static_cast<uint64_t>(piece::Type::EMPTY) << 12;
+    }
+    return static_cast<uint64_t>(move.from) | (static_cast<uint64_t>(move.to) << 6) |
+           (static_cast<uint64_t>(move.piece_type) << 12) | (static_cast<uint64_t>(move.color) << 15) |
+           (static_cast<uint64_t>(move.move_type) << 16) | (static_cast<uint64_t>(move.promotion) << 19);
+}
+
+moves::Move unpack_move(uint64_t bits) {
+    auto piece_type = static_cast<piece::Type>((bits >> 12) & 7);
+    if (piece_type == piece::Type::EMPTY) {
+        return moves::Move();
+    }
+    return moves::Move(static_cast<int>(bits & 63), static_cast<int>((bits >> 6) & 63), piece_type,
+                       static_cast<piece::Color>((bits >> 15) & 1), static_cast<moves::Type>((bits >> 16) & 7),
+                       static_cast<piece::Type>((bits >> 19) & 7));
+}
+
+uint64_t pack_data(int depth, int score, NodeType type, const moves::Move &best_move, uint8_t generation) {
+    return (static_cast<uint64_t>(score) & ((1ULL << SCORE_BITS) - 1)) | (pack_move(best_move) << MOVE_SHIFT) |
+           (static_cast<uint64_t>(type) << TYPE_SHIFT) | (static_cast<uint64_t>(depth + 1) << DEPTH_SHIFT) |
+           (static_cast<uint64_t>(generation) << GENERATION_SHIFT);
+}
+
+int depth_of(uint64_t data) {
+    return static_cast<int>((data >> DEPTH_SHIFT) & 127) - 1;
+}
+
+uint8_t generation_of(uint64_t data) {
+    return static_cast<uint8_t>(data >> GENERATION_SHIFT);
+}
+
+// Each word is loaded and stored atomically; relaxed order is enough, as the key check catches
+// slots whose words were written by different stores
+uint64_t load_word(const uint64_t &word) {
+    return __atomic_load_n(&word, __ATOMIC_RELAXED);
+}
+
+void store_word(uint64_t &word, uint64_t value) {
+    __atomic_store_n(&word, value, __ATOMIC_RELAXED);
+}
 
 void TranspositionTable::store(uint64_t key, int depth, int score, NodeType type, const moves::Move &best_move) {
     size_t index = key % size;
     TTEntry &entry = table[index];
+    uint8_t current = generation.load(std::memory_order_relaxed);
 
-    // Replace if new position is searched to a greater or equal depth
-    if (depth >= entry.depth) {
-        entry.key = key;
-        entry.depth = depth;
-        entry.score = score;
-        entry.type = type;
-        entry.best_move = best_move;
+    // Replace stale entries, or if new position is searched to a greater or equal depth
+    uint64_t old_data = load_word(entry.data);
+    if (generation_of(old_data) != current || depth >= depth_of(old_data)) {
+        uint64_t data = pack_data(depth, score, type, best_move, current);
+        store_word(entry.key_xor_data, key ^ data);
+        store_word(entry.data, data);
     }
 }
 
 bool TranspositionTable::probe(uint64_t key, int depth, int &score, NodeType &type, moves::Move &best_move) {
     size_t index = key % size;
-    TTEntry &entry = table[index];
+    const TTEntry &entry = table[index];
 
-    if (entry.key == key && entry.depth >= depth) {
-        score = entry.score;
-        type = entry.type;
-        best_move = entry.best_move;
+    uint64_t data = load_word(entry.data);
+    if ((load_word(entry.key_xor_data) ^ data) == key && depth_of(data) >= depth) {
+        score = static_cast<int>(static_cast<int64_t>(data << (64 - SCORE_BITS)) >> (64 - SCORE_BITS));
+        type = static_cast<NodeType>((data >> TYPE_SHIFT) & 3);
+        best_move = unpack_move(data >> MOVE_SHIFT);
         return true;
     }
 
     return false;
 }
 
+void TranspositionTable::resize(size_t size_mb) {
+    allocate(size_mb);
+    clear();
+}
+
+size_t TranspositionTable::size_mb() const {
+    // Rounded up, as allocate() rounds the entry count down
+    return (size * sizeof(TTEntry) + 1024 * 1024 - 1) / (1024 * 1024);
+}
+
 void TranspositionTable::clear() {
-    for (auto &entry : table) {
-        entry.key = 0;
-        entry.depth = -1;
-        entry.score = 0;
-        entry.type = NodeType::EXACT;
-        entry.best_move = moves::Move();
+    TTEntry empty;
+    empty.data = pack_data(-1, 0, NodeType::EXACT, moves::Move(), generation.load(std::memory_order_relaxed));
+    empty.key_xor_data = empty.data; // Key 0
+
+    // Small tables are not worth the threads
+    size_t threads = std::min<size_t>(init_threads, std::max<size_t>(1, size * sizeof(TTEntry) / HUGE_PAGE_SIZE));
+    auto fill = [this, &empty, threads](size_t slice) {
+        std::fill(table + size * slice / threads, table + size * (slice + 1) / threads, empty);
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t slice = 1; slice < threads; ++slice) {
+        workers.emplace_back(fill, slice);
+    }
+    fill(0);
+    for (auto &worker : workers) {
+        worker.join();
     }
 }
 
+void TranspositionTable::new_search() {
+    generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Snapshots hold the entries' raw bytes, so they are only read back by the same build. Bump the
+// version whenever TTEntry or the meaning of its fields (e.g. the score encoding) changes.
+const char SNAPSHOT_MAGIC[4] = {'C', 'E', 'T', 'T'};
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t zobrist_seed;
+    uint64_t entry_size;
+    uint64_t entry_count;
+    uint64_t generation;
+};
+
+bool TranspositionTable::save(const std::string &path) const {
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.zobrist_seed = zobrist::ZOBRIST_SEED;
+    header.entry_size = sizeof(TTEntry);
+    header.entry_count = size;
+    header.generation = generation.load(std::memory_order_relaxed);
+
+    // Written next to the target and renamed over it, so a crash never leaves a torn snapshot
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(table), static_cast<std::streamsize>(size * sizeof(TTEntry)));
+        if (!out.flush()) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool TranspositionTable::load(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    SnapshotHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.zobrist_seed != zobrist::ZOBRIST_SEED || header.entry_size != sizeof(TTEntry) || header.entry_count == 0) {
+        return false;
+    }
+
+    // Same table size: read straight into the table, which a short read leaves empty
+    if (header.entry_count == size) {
+        if (!in.read(reinterpret_cast<char *>(table), static_cast<std::streamsize>(size * sizeof(TTEntry)))) {
+            clear();
+            return false;
+        }
+        generation.store(static_cast<uint8_t>(header.generation), std::memory_order_relaxed);
+        return true;
+    }
+
+    // Different table size: stream the entries through a small buffer, keeping the deepest one for each slot
+    clear();
+    std::vector<TTEntry> chunk(std::min<uint64_t>(header.entry_count, 1 << 16));
+    for (uint64_t remaining = header.entry_count; remaining > 0;) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(remaining, chunk.size()));
+        if (!in.read(reinterpret_cast<char *>(chunk.data()), static_cast<std::streamsize>(count * sizeof(TTEntry)))) {
+            clear();
+            return false;
+        }
+        remaining -= count;
+
+        for (size_t i = 0; i < count; ++i) {
+            const TTEntry &entry = chunk[i];
+            if (depth_of(entry.data) < 0) {
+                continue;
+            }
+            TTEntry &slot = table[(entry.key_xor_data ^ entry.data) % size];
+            if (depth_of(entry.data) > depth_of(slot.data)) {
+                slot = entry;
+            }
+        }
+    }
+    generation.store(static_cast<uint8_t>(header.generation), std::memory_order_relaxed);
+    return true;
+}
+
+int TranspositionTable::hashfull() const {
+    size_t sample = std::min<size_t>(1000, size);
+    if (sample == 0) {
+        return 0;
+    }
+
+    uint8_t current = generation.load(std::memory_order_relaxed);
+    size_t used = 0;
+    for (size_t i = 0; i < sample; ++i) {
+        uint64_t data = load_word(table[i].data);
+        if (depth_of(data) >= 0 && generation_of(data) == current) {
+            ++used;
+        }
+    }
+
+    return static_cast<int>(used * 1000 / sample);
+}
+
 } // namespace transposition
 } // namespace chess_engine
\ No newline at end of file
@@ -3,32 +3,90 @@
 
 #include "../enums.h"
 #include "../moves/moves.h"
+#include <atomic>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 namespace chess_engine {
 namespace transposition {
 
+// The threads of a search share the table without locks, so a slot can be read while another
+// thread writes it. Each word is read and written atomically, and the key is stored xor-ed
+// with the data: a slot whose words come from two different stores fails the key check.
 struct TTEntry {
-    uint64_t key;          // Zobrist hash of the position
-    int depth;             // Depth of the search
-    int score;             // Evaluation score
-    NodeType type;         // Type of node (EXACT, ALPHA, or BETA)
-    moves::Move best_move; // Best move found for this position
+    uint64_t key_xor_data; // Zobrist hash of the position ^ data
+    uint64_t data;         // Score, best move, node type, depth and generation (see transposition.cpp)
 };
 
+// Pages backing the table. Random probes into a multi-GB table miss the TLB on nearly every
+// access with 4 KB pages; 2 MB pages cut the misses by the same factor of 512.
+enum class PageMode {
+    NORMAL,      // Plain 4 KB pages
+    TRANSPARENT, // madvise(MADV_HUGEPAGE): the kernel backs the table with huge pages when it can
+    HUGETLB      // MAP_HUGETLB: reserved huge pages (vm.nr_hugepages), all or nothing
+};
+
+const char *page_mode_name(PageMode mode);
+
 // Declare the transposition table class (implementation will be in .cpp file)
 class TranspositionTable {
   public:
-    TranspositionTable(size_t size_mb);
+    // Pages are tried from the requested mode down to NORMAL until an allocation succeeds
+    TranspositionTable(size_t size_mb, PageMode pages = PageMode::HUGETLB);
     ~TranspositionTable();
 
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
     void store(uint64_t key, int depth, int score, NodeType type, const moves::Move &best_move);
     bool probe(uint64_t key, int depth, int &score, NodeType &type, moves::Move &best_move);
     void clear();
 
+    // Threads that zero the table on clear and resize. Each first touches its own slice, so on
+    // NUMA machines the pages are spread over the nodes the search threads run on.
+    void set_init_threads(int threads);
+
+    // Start loading the slot of a key that will be probed soon
+    void prefetch(uint64_t key) const {
+        __builtin_prefetch(&table[key % size]);
+    }
+
+    // Start a new search: entries from earlier searches become replaceable regardless of depth
+    void new_search();
+
+    // Reallocate the table; must not be called while a search is running. Throws
+    // std::bad_alloc, keeping the current table, if the new one cannot be mapped.
+    void resize(size_t size_mb);
+
+    // Size the table was allocated with
+    size_t size_mb() const;
+
+    // Pages the table actually got
+    PageMode page_mode() const;
+
+    // Write the table to a file, or fill it from one written with the same format version and
+    // Zobrist keys. A snapshot of another size is rehashed into this table. Both return false on
+    // I/O errors or an incompatible file. An incompatible snapshot leaves the table unchanged and a
+    // truncated one leaves it empty (load); the file is left untouched (save). Must not be called
+    // while a search is running.
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+
+    // Permille of the table filled by the current search, sampled from the first 1000 entries (UCI "hashfull")
+    int hashfull() const;
+
   private:
-    std::vector<TTEntry> table;
-    size_t size;
+    void allocate(size_t size_mb);
+    void release();
+
+    TTEntry *table = nullptr;
+    size_t size = 0;
+    size_t mapped_bytes = 0; // Length of the mapping, rounded up to whole huge pages
+    PageMode requested_pages;
+    PageMode pages = PageMode::NORMAL;
+    int init_threads = 1;
+    std::atomic<uint8_t> generation{0};
 };
 
 } // namespace transposition
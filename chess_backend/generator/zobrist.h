@@ -2,6 +2,7 @@
 #define CHESS_ENGINE_ZOBRIST_H
 
 #include "../enums.h"
+#include "../moves/moves.h"
 #include <array>
 #include <cstdint>
 #include "../structure/game_state.h"
@@ -9,14 +10,32 @@
 namespace chess_engine {
 namespace zobrist {
 
+// Fixed so that hashes, and with them TT collisions and node counts, are identical on every
+// run. Keys are taken straight from the engine: its output sequence is fixed by the standard,
+// unlike that of a distribution. Saved transposition tables are only valid for this seed.
+constexpr uint64_t ZOBRIST_SEED = 0x9E3779B97F4A7C15ULL;
+
 extern std::array<std::array<uint64_t, 64>, 12> piece_keys;
 extern std::array<uint64_t, 16> castling_keys;
 extern std::array<uint64_t, 8> en_passant_keys;
 extern uint64_t side_to_move_key;
 
+// Number of keys of a Polyglot book hash
+constexpr int POLYGLOT_KEY_COUNT = 781;
+
+// polyglot_hash of the initial position, as published with the Polyglot format
+constexpr uint64_t POLYGLOT_START_KEY = 0x463B96181691FC9CULL;
+
 void init_zobrist_keys();
 uint64_t compute_hash(const game_state::GameState &state);
 
+// compute_hash of the position after a legal move, updated from the hash before it without making
+// the move. Cheap enough to prefetch the child's table slot with.
+uint64_t hash_after(uint64_t hash, const moves::Move &move, const game_state::GameState &state);
+
+// Key of a position in a Polyglot book, computed by Polyglot's rules
+uint64_t polyglot_hash(const game_state::GameState &state);
+
 } // namespace zobrist
 } // namespace chess_engine
 
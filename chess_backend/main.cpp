@@ -1,11 +1,19 @@
 #include "enums.h"
+#include "generator/book.h"
 #include "generator/evaluate.h"
+#include "generator/nnue.h"
 #include "generator/search.h"
+#include "generator/tablebase.h"
 #include "generator/transposition.h"
 #include "generator/zobrist.h"
 #include "moves/moves.h"
+#include "server/config.h"
+#include "server/metrics.h"
+#include "server/session.h"
+#include "server/spsc_queue.h"
 #include "structure/game_state.h"
 #include "structure/square.h"
+#include "utils.h"
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
@@ -14,12 +22,21 @@
 #include <boost/config.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <csignal>
 #include <cstdlib>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <new>
+#include <pthread.h>
 #include <string>
 #include <thread>
+#include <vector>
 
 // namespace chess_engine {
 // namespace search {
@@ -129,25 +146,340 @@ namespace net = boost::asio;      // From <boost/asio.hpp>
 using tcp = boost::asio::ip::tcp; // From <boost/asio/ip/tcp.hpp>
 using namespace chess_engine;
 
-namespace chess_engine {
-namespace search {
+// Decode a percent-encoded query string value ('+' stands for a space)
+std::string url_decode(beast::string_view value) {
+    std::string decoded;
+    decoded.reserve(value.size());
+
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '+') {
+            decoded += ' ';
+        } else if (value[i] == '%' && i + 2 < value.size() &&
+                   std::isxdigit(static_cast<unsigned char>(value[i + 1])) && std::isxdigit(static_cast<unsigned char>(value[i + 2]))) {
+            decoded += static_cast<char>(std::stoi(std::string(value.substr(i + 1, 2)), nullptr, 16));
+            i += 2;
+        } else {
+            decoded += value[i];
+        }
+    }
+
+    return decoded;
+}
+
+// Collect the query parameters of a request target such as "/stream?fen=...&depth=6"
+boost::property_tree::ptree parse_query(beast::string_view target) {
+    boost::property_tree::ptree params;
+    size_t query_start = target.find('?');
+    if (query_start == beast::string_view::npos) {
+        return params;
+    }
+
+    beast::string_view query = target.substr(query_start + 1);
+    while (!query.empty()) {
+        size_t separator = query.find('&');
+        beast::string_view pair = query.substr(0, separator);
+        size_t equals = pair.find('=');
+        if (equals != beast::string_view::npos) {
+            params.put(std::string(pair.substr(0, equals)), url_decode(pair.substr(equals + 1)));
+        }
+        if (separator == beast::string_view::npos) {
+            break;
+        }
+        query = query.substr(separator + 1);
+    }
+
+    return params;
+}
+
+// Settings the server was started with; read-only once main() has loaded them
+config::Config server_config;
+
+// Read the optional "depth", "movetime" (ms), "nodes" and "multipv" settings of a request.
+// Missing ones take the configured defaults, and every search is capped at max_search_time_s
+// so an abandoned request cannot run forever.
+search::SearchLimits parse_limits(const boost::property_tree::ptree &params) {
+    search::SearchLimits limits;
+    limits.depth = params.get<int>("depth", server_config.depth);
+    limits.movetime_ms = params.get<int64_t>("movetime", server_config.movetime_ms);
+    limits.nodes = params.get<uint64_t>("nodes", 0);
+    limits.multipv = std::min(std::max(params.get<int>("multipv", 1), 1), search::MAX_MULTIPV);
+    limits.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(server_config.max_search_time_s);
+    return limits;
+}
+
+// JSON array of moves in UCI notation
+std::string pv_to_json(const std::vector<moves::Move> &pv) {
+    std::string json;
+    for (const auto &move : pv) {
+        json += (json.empty() ? "\"" : ", \"") + moves::to_uci(move) + "\"";
+    }
+    return "[" + json + "]";
+}
+
+// Serialize one iterative-deepening report as a JSON object
+std::string search_info_to_json(const search::SearchInfo &info) {
+    // Mates also carry their distance in moves, negative when the side to move gets mated
+    bool mate_score = evaluate::is_mate_score(info.score);
+    std::string mate = mate_score ? ", \"mate\": " + std::to_string(evaluate::mate_in_moves(info.score)) : "";
+    int score = mate_score ? info.score : evaluate::to_centipawns(info.score);
+    return "{\"depth\": " + std::to_string(info.depth) +
+           ", \"multipv\": " + std::to_string(info.multipv) +
+           ", \"score\": " + std::to_string(score) + mate +
+           ", \"nodes\": " + std::to_string(info.nodes) +
+           ", \"nps\": " + std::to_string(info.nps) +
+           ", \"time\": " + std::to_string(info.time_ms) +
+           ", \"hashfull\": " + std::to_string(info.hashfull) +
+           ", \"tbhits\": " + std::to_string(info.tbhits) +
+           ", \"pv\": " + pv_to_json(info.pv) + "}";
+}
+
+// Keep the latest report of every MultiPV line, best line first
+search::InfoCallback collect_lines(std::vector<search::SearchInfo> &lines) {
+    return [&lines](const search::SearchInfo &info) {
+        if (info.multipv > static_cast<int>(lines.size())) {
+            lines.resize(info.multipv);
+        }
+        lines[info.multipv - 1] = info;
+    };
+}
+
+// The ", "pv": [...]" and, for a MultiPV search, ", "lines": [...]" members of a move response
+std::string lines_to_json(const std::vector<search::SearchInfo> &lines) {
+    if (lines.empty()) {
+        return "";
+    }
+    if (lines.size() < 2) {
+        return ", \"pv\": " + pv_to_json(lines.front().pv);
+    }
+
+    std::string json;
+    for (const auto &line : lines) {
+        json += (json.empty() ? "" : ", ") + search_info_to_json(line);
+    }
+    return ", \"pv\": " + pv_to_json(lines.front().pv) + ", \"lines\": [" + json + "]";
+}
+
+// True once the peer has closed its end of the connection
+bool is_peer_closed(tcp::socket &socket) {
+    char byte;
+    beast::error_code ec, mode_ec;
+    socket.non_blocking(true, mode_ec);
+    size_t received = socket.receive(net::buffer(&byte, 1), tcp::socket::message_peek, ec);
+    socket.non_blocking(false, mode_ec);
+
+    if (ec == net::error::would_block) {
+        return false;
+    }
+    return ec || received == 0;
+}
+
+// Run a search on a worker thread while watching the connection, cancelling the
+// search as soon as the client goes away. Parse errors are rethrown to the caller.
+moves::Move search_while_connected(tcp::socket &socket, const std::function<moves::Move(const search::CancellationToken &)> &search) {
+    search::CancellationToken token;
+    std::future<moves::Move> result = std::async(std::launch::async, [&]() {
+        return search(token);
+    });
+
+    while (result.wait_for(std::chrono::milliseconds(20)) != std::future_status::ready) {
+        if (!token.is_cancelled() && is_peer_closed(socket)) {
+            token.cancel();
+        }
+    }
+
+    return result.get();
+}
+
+void json_response(http::response<http::string_body> &res, http::status status, const std::string &body) {
+    res.result(status);
+    res.body() = body;
+    res.set(http::field::content_type, "application/json");
+    res.set(http::field::access_control_allow_origin, "*"); // Handle CORS
+    res.prepare_payload();
+}
+
+// Game sessions:
+//   POST   /session                 {"fen": ...} (optional)    -> {"id": ...}
+//   POST   /session/<id>/move       {"move": "e2e4"}
+//   POST   /session/<id>/bestmove   {"depth", "movetime", "nodes", "play", "ponder"} -> the engine's
+//                                   move, played on the session unless "play" is false. With "ponder"
+//                                   the engine then searches the expected reply until the next move.
+//   DELETE /session/<id>
+void handle_session_request(tcp::socket &socket, const http::request<http::string_body> &req, http::response<http::string_body> &res) {
+    // Split "/session/<id>/<action>"
+    std::string path(req.target().substr(0, req.target().find('?')));
+    std::string id, action;
+    if (path.size() > 9) {
+        std::string rest = path.substr(9);
+        size_t slash = rest.find('/');
+        id = rest.substr(0, slash);
+        action = (slash == std::string::npos) ? "" : rest.substr(slash + 1);
+    }
+
+    boost::property_tree::ptree params;
+    if (!req.body().empty()) {
+        try {
+            std::istringstream iss(req.body());
+            boost::property_tree::read_json(iss, params);
+        } catch (const std::exception &e) {
+            json_response(res, http::status::bad_request, "{\"error\": \"Invalid JSON format\"}");
+            return;
+        }
+    }
+
+    if (id.empty() && req.method() == http::verb::post) {
+        try {
+            std::string new_id = session::create(params.get<std::string>("fen", utils::START_FEN));
+            json_response(res, http::status::created, "{\"id\": \"" + new_id + "\"}");
+        } catch (const std::exception &e) {
+            json_response(res, http::status::bad_request, "{\"error\": \"Invalid FEN: " + std::string(e.what()) + "\"}");
+        }
+        return;
+    }
+
+    if (!id.empty() && action.empty() && req.method() == http::verb::delete_) {
+        if (session::remove(id)) {
+            res.result(http::status::no_content);
+            res.set(http::field::access_control_allow_origin, "*"); // Handle CORS
+        } else {
+            json_response(res, http::status::not_found, "{\"error\": \"Unknown session\"}");
+        }
+        return;
+    }
+
+    if (req.method() != http::verb::post || (action != "move" && action != "bestmove")) {
+        json_response(res, http::status::not_found, "{\"error\": \"Unknown session request\"}");
+        return;
+    }
+
+    std::shared_ptr<session::Session> game = session::find(id);
+    if (game == nullptr) {
+        json_response(res, http::status::not_found, "{\"error\": \"Unknown session\"}");
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(game->mutex);
 
-transposition::TranspositionTable tt(64); // 64 MB table
+    if (action == "move") {
+        std::string move = params.get<std::string>("move", "");
+        if (!game->play(move)) {
+            json_response(res, http::status::bad_request, "{\"error\": \"Illegal move\"}");
+            return;
+        }
+        json_response(res, http::status::ok, "{\"move\": \"" + move + "\"}");
+        return;
+    }
+
+    search::SearchLimits limits;
+    bool play, ponder;
+    try {
+        limits = parse_limits(params);
+        play = params.get<bool>("play", true);
+        ponder = params.get<bool>("ponder", false);
+    } catch (const std::exception &e) {
+        json_response(res, http::status::bad_request, "{\"error\": \"Invalid limits\"}");
+        return;
+    }
+
+    std::vector<search::SearchInfo> lines;
+    moves::Move best_move = search_while_connected(socket, [&](const search::CancellationToken &token) {
+        return game->search(limits, token, collect_lines(lines));
+    });
+    std::vector<moves::Move> pv = lines.empty() ? std::vector<moves::Move>() : lines.front().pv;
+
+    if (best_move.is_null()) {
+        json_response(res, http::status::conflict, "{\"error\": \"Game over\"}");
+        return;
+    }
+
+    std::string move = moves::to_uci(best_move);
+    std::string ponder_field;
+    if (play) {
+        game->play(move);
+
+        // Think on the opponent's time about the reply the search expects
+        if (ponder && pv.size() >= 2 && pv[0] == best_move) {
+            game->start_ponder(pv[1]);
+            ponder_field = ", \"ponder\": \"" + moves::to_uci(pv[1]) + "\"";
+        }
+    }
+
+    std::string from_str = square::int_position_to_string(best_move.from);
+    std::string to_str = square::int_position_to_string(best_move.to);
+    json_response(res, http::status::ok, "{\"from\": \"" + from_str + "\", \"to\": \"" + to_str + "\", \"move\": \"" + move + "\"" + ponder_field + lines_to_json(lines) + "}");
+}
+
+// Transposition table administration:
+//   GET    /hash                     -> {"mb": ..., "pages": ..., "hashfull": ...}
+//   POST   /hash    {"mb": 256}      Reallocate the table, stopping running searches early; 507 and
+//                                    the table unchanged if the memory cannot be had
+//   DELETE /hash                     Clear the table
+void handle_hash_request(const http::request<http::string_body> &req, http::response<http::string_body> &res) {
+    if (req.method() == http::verb::post) {
+        size_t size_mb;
+        try {
+            std::istringstream iss(req.body());
+            boost::property_tree::ptree pt;
+            boost::property_tree::read_json(iss, pt);
+            int requested = pt.get<int>("mb");
+            if (requested < 1 || static_cast<size_t>(requested) > config::MAX_HASH_MB) {
+                throw std::invalid_argument("mb out of range");
+            }
+            size_mb = static_cast<size_t>(requested);
+        } catch (const std::exception &e) {
+            json_response(res, http::status::bad_request, "{\"error\": \"Invalid hash size (1 to " +
+                                                              std::to_string(config::MAX_HASH_MB) + " MB)\"}");
+            return;
+        }
+        try {
+            search::resize_tt(size_mb);
+        } catch (const std::bad_alloc &) {
+            json_response(res, http::status::insufficient_storage, "{\"error\": \"Cannot allocate " +
+                                                                       std::to_string(size_mb) + " MB\"}");
+            return;
+        }
+    } else if (req.method() == http::verb::delete_) {
+        search::clear_tt();
+    } else if (req.method() != http::verb::get) {
+        json_response(res, http::status::method_not_allowed, "{\"error\": \"Method not allowed\"}");
+        return;
+    }
 
-} // namespace search
-} // namespace chess_engine
+    json_response(res, http::status::ok, "{\"mb\": " + std::to_string(search::tt.size_mb()) +
+                                             ", \"pages\": \"" + transposition::page_mode_name(search::tt.page_mode()) +
+                                             "\", \"hashfull\": " + std::to_string(search::tt.hashfull()) + "}");
+}
 
 // Function to handle CORS and respond to POST requests
-void handle_request(http::request<http::string_body> &&req, http::response<http::string_body> &res) {
+void handle_request(tcp::socket &socket, http::request<http::string_body> &&req, http::response<http::string_body> &res) {
     if (req.method() == http::verb::options) {
         // Handle preflight request (CORS)
         res.result(http::status::no_content);
         res.set(http::field::access_control_allow_origin, "*");
-        res.set(http::field::access_control_allow_methods, "POST, OPTIONS");
+        res.set(http::field::access_control_allow_methods, "GET, POST, DELETE, OPTIONS");
         res.set(http::field::access_control_allow_headers, "Content-Type, Authorization");
         return;
     }
 
+    if (req.method() == http::verb::get && req.target() == "/metrics") {
+        // Prometheus scrape: counters are aggregated here, never on the search path
+        res.body() = metrics::render(search::tt.hashfull());
+        res.set(http::field::content_type, "text/plain; version=0.0.4");
+        res.prepare_payload();
+        res.result(http::status::ok);
+        return;
+    }
+
+    beast::string_view target = req.target();
+    if (target == "/session" || target.starts_with("/session/")) {
+        handle_session_request(socket, req, res);
+        return;
+    }
+    if (target == "/hash") {
+        handle_hash_request(req, res);
+        return;
+    }
+
     if (req.method() == http::verb::post) {
         // Parse the JSON body
         std::string body = req.body();
@@ -158,18 +490,34 @@ void handle_request(http::request<http::string_body> &&req, http::response<http:
         try {
             boost::property_tree::read_json(iss, pt);
 
-            // Extract the FEN string
+            // Extract the FEN string, rejecting a malformed position before searching it
             std::string fen = pt.get<std::string>("fen");
-
-            // Calculate the best move from the FEN string
-            moves::Move best_move = search::calculate_best_move(fen);
+            try {
+                game_state::set_game_state(fen);
+            } catch (const std::invalid_argument &e) {
+                json_response(res, http::status::bad_request, "{\"error\": \"Invalid FEN: " + std::string(e.what()) + "\"}");
+                return;
+            }
+
+            // Calculate the best move from the FEN string within the requested limits
+            search::SearchLimits limits = parse_limits(pt);
+            std::vector<search::SearchInfo> lines;
+            moves::Move best_move = search_while_connected(socket, [&](const search::CancellationToken &token) {
+                return search::calculate_best_move(fen, limits, collect_lines(lines), &token);
+            });
+
+            // Only a position without legal moves has no best move, as for sessions
+            if (best_move.is_null()) {
+                json_response(res, http::status::conflict, "{\"error\": \"Game over\"}");
+                return;
+            }
 
             // Convert the move positions to chess notation strings using square::int_position_to_string
             std::string from_str = square::int_position_to_string(best_move.from);
             std::string to_str = square::int_position_to_string(best_move.to);
 
             // Respond with the move in JSON format
-            std::string response_body = "{\"from\": \"" + from_str + "\", \"to\": \"" + to_str + "\"}";
+            std::string response_body = "{\"from\": \"" + from_str + "\", \"to\": \"" + to_str + "\"" + lines_to_json(lines) + "}";
             res.body() = response_body;
             res.set(http::field::content_type, "application/json");
             res.set(http::field::access_control_allow_origin, "*"); // Handle CORS
@@ -189,8 +537,148 @@ void handle_request(http::request<http::string_body> &&req, http::response<http:
     res.prepare_payload();
 }
 
+// Send a single Server-Sent Event as one HTTP chunk
+void write_event(tcp::socket &socket, const std::string &event, const std::string &data, beast::error_code &ec) {
+    std::string payload = "event: " + event + "\ndata: " + data + "\n\n";
+    net::write(socket, http::make_chunk(net::buffer(payload)), ec);
+}
+
+// Stream the search progress for a FEN as Server-Sent Events: "info" after every iteration,
+// then "bestmove", or "gameover" if the side to move has no legal moves. The search runs on its
+// own thread and hands every report to this (I/O) thread through a lock-free queue, so a slow
+// client never stalls the search.
+void stream_search(tcp::socket &socket, const std::string &fen, const search::SearchLimits &limits) {
+    spsc_queue::SpscQueue<search::SearchInfo, 64> info_queue;
+    search::CancellationToken token;
+    std::atomic<bool> search_done{false};
+    moves::Move best_move;
+    std::string search_error;
+
+    std::thread search_thread([&]() {
+        try {
+            best_move = search::calculate_best_move(fen, limits, [&](const search::SearchInfo &info) {
+                // Drop the report rather than block if the client is not keeping up
+                info_queue.push(info);
+            }, &token);
+        } catch (const std::exception &e) {
+            search_error = e.what();
+        }
+        search_done.store(true, std::memory_order_release);
+    });
+
+    http::response<http::empty_body> res{http::status::ok, 11};
+    res.set(http::field::content_type, "text/event-stream");
+    res.set(http::field::cache_control, "no-cache");
+    res.set(http::field::access_control_allow_origin, "*"); // Handle CORS
+    res.chunked(true);
+
+    beast::error_code ec;
+    http::response_serializer<http::empty_body> serializer{res};
+    http::write_header(socket, serializer, ec);
+
+    search::SearchInfo info;
+    while (!ec) {
+        // Read the flag before draining so that no report pushed before completion is lost
+        bool done = search_done.load(std::memory_order_acquire);
+        while (!ec && info_queue.pop(info)) {
+            write_event(socket, "info", search_info_to_json(info), ec);
+        }
+        if (done) {
+            break;
+        }
+        if (is_peer_closed(socket)) {
+            ec = net::error::connection_reset;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    // The client stopped listening: no point finishing the search
+    if (ec) {
+        token.cancel();
+    }
+    search_thread.join();
+
+    if (ec) {
+        return;
+    }
+
+    if (!search_error.empty()) {
+        write_event(socket, "error", "{\"error\": \"Invalid FEN: " + search_error + "\"}", ec);
+    } else if (best_move.is_null()) {
+        // No legal moves: the stream ends with the result instead of a best move
+        game_state::GameState state = game_state::set_game_state(fen);
+        std::string result = state.is_in_check(state.turn) ? "checkmate" : "stalemate";
+        write_event(socket, "gameover", "{\"result\": \"" + result + "\"}", ec);
+    } else {
+        std::string from_str = square::int_position_to_string(best_move.from);
+        std::string to_str = square::int_position_to_string(best_move.to);
+        write_event(socket, "bestmove", "{\"from\": \"" + from_str + "\", \"to\": \"" + to_str + "\"}", ec);
+    }
+    net::write(socket, http::make_chunk_last(), ec);
+}
+
+// Parse the FEN of a /stream request and stream the search, returning the HTTP status sent
+int handle_stream_request(tcp::socket &socket, const http::request<http::string_body> &req) {
+    boost::property_tree::ptree params;
+    if (req.method() == http::verb::post) {
+        try {
+            std::istringstream iss(req.body());
+            boost::property_tree::read_json(iss, params);
+        } catch (const std::exception &e) {
+            params.clear();
+        }
+    } else {
+        params = parse_query(req.target());
+    }
+
+    std::string fen = params.get<std::string>("fen", "");
+    search::SearchLimits limits;
+    try {
+        limits = parse_limits(params);
+    } catch (const std::exception &e) {
+        fen.clear();
+    }
+
+    if (fen.empty()) {
+        http::response<http::string_body> res{http::status::bad_request, req.version()};
+        res.set(http::field::access_control_allow_origin, "*"); // Handle CORS
+        res.body() = "Missing FEN";
+        res.prepare_payload();
+        http::write(socket, res);
+        return res.result_int();
+    }
+
+    stream_search(socket, fen, limits);
+    return static_cast<int>(http::status::ok);
+}
+
+metrics::Endpoint classify_request(const http::request<http::string_body> &req) {
+    beast::string_view target = req.target();
+    beast::string_view path = target.substr(0, target.find('?'));
+
+    if (path == "/stream") {
+        return metrics::Endpoint::STREAM;
+    }
+    if (path == "/metrics") {
+        return metrics::Endpoint::METRICS;
+    }
+    if (path == "/session" || path.starts_with("/session/")) {
+        return metrics::Endpoint::SESSION;
+    }
+    if (path == "/hash") {
+        return metrics::Endpoint::OTHER;
+    }
+    if (req.method() == http::verb::post) {
+        return metrics::Endpoint::MOVE;
+    }
+    return metrics::Endpoint::OTHER;
+}
+
 // This function will run a single connection session
 void do_session(tcp::socket socket) {
+    metrics::connection_opened();
+
     try {
         beast::flat_buffer buffer;
         http::request<http::string_body> req;
@@ -198,32 +686,126 @@ void do_session(tcp::socket socket) {
         // Read the request
         http::read(socket, buffer, req);
 
-        // Create a response
-        http::response<http::string_body> res;
+        auto start_time = std::chrono::steady_clock::now();
+        metrics::Endpoint endpoint = classify_request(req);
+        int status;
 
-        // Handle the request and generate a response
-        handle_request(std::move(req), res);
+        if (endpoint == metrics::Endpoint::STREAM && req.method() != http::verb::options) {
+            // Progress streaming: GET /stream?fen=... (EventSource) or POST /stream with a JSON body
+            status = handle_stream_request(socket, req);
+        } else {
+            // Create a response
+            http::response<http::string_body> res;
 
-        // Send the response
-        http::write(socket, res);
+            // Handle the request and generate a response
+            handle_request(socket, std::move(req), res);
+
+            // Send the response
+            http::write(socket, res);
+            status = res.result_int();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        metrics::record_request(endpoint, status, elapsed.count());
     } catch (std::exception const &e) {
         std::cerr << "Error: " << e.what() << "\n";
     }
+
+    metrics::connection_closed();
 }
 
-int main() {
+// On SIGINT or SIGTERM, stop the running searches, save the transposition table and exit. The
+// signals are blocked here, before any other thread starts, and every thread inherits the mask,
+// so only the waiting thread ever receives them.
+void save_tt_on_shutdown(const std::string &snapshot_path) {
+    sigset_t shutdown_signals;
+    sigemptyset(&shutdown_signals);
+    sigaddset(&shutdown_signals, SIGINT);
+    sigaddset(&shutdown_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &shutdown_signals, nullptr);
+
+    std::thread([shutdown_signals, snapshot_path]() {
+        int signal = 0;
+        sigwait(&shutdown_signals, &signal);
+        if (search::save_tt(snapshot_path)) {
+            std::cout << "Transposition table saved to " << snapshot_path << ".\n";
+        } else {
+            std::cerr << "Cannot save the transposition table to " << snapshot_path << "\n";
+        }
+        std::cout.flush();
+        std::_Exit(0); // Running sessions are abandoned, as on any shutdown
+    }).detach();
+}
+
+int main(int argc, char **argv) {
+    try {
+        server_config = config::load(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
     // Initialize Zobrist keys
     zobrist::init_zobrist_keys();
 
+    search::thread_count = server_config.threads;
+    search::tt.set_init_threads(server_config.threads);
+    if (search::tt.size_mb() != server_config.hash_mb) {
+        try {
+            search::resize_tt(server_config.hash_mb);
+        } catch (const std::bad_alloc &) {
+            std::cerr << "Error: cannot allocate a " << server_config.hash_mb << " MB transposition table\n";
+            return EXIT_FAILURE;
+        }
+    }
+    session::set_max_sessions(server_config.max_sessions);
+
+    // Syzygy tablebases from a local directory (or ':'-separated list of them), if configured
+    if (!server_config.syzygy_path.empty()) {
+        if (tablebase::init(server_config.syzygy_path)) {
+            std::cout << "Syzygy tablebases up to " << tablebase::max_pieces() << " pieces loaded.\n";
+        } else {
+            std::cerr << "No Syzygy tablebases found in " << server_config.syzygy_path << "\n";
+        }
+    }
+
+    // Polyglot opening book, consulted before searching the first book_max_ply plies of a game
+    book::set_max_ply(server_config.book_max_ply);
+    if (!server_config.book_path.empty()) {
+        if (book::open(server_config.book_path)) {
+            std::cout << "Opening book with " << book::size() << " entries loaded.\n";
+        } else {
+            std::cerr << "Cannot open opening book " << server_config.book_path << "\n";
+        }
+    }
+
+    // NNUE evaluation, if a network is configured; the hand-written evaluation otherwise
+    if (!server_config.eval_file.empty()) {
+        if (nnue::load(server_config.eval_file)) {
+            std::cout << "NNUE network loaded (" << nnue::simd_name() << " inference).\n";
+        } else {
+            std::cerr << "Cannot load NNUE network " << server_config.eval_file << "\n";
+        }
+    }
+
+    // Warm start: the transposition table of the previous run, saved on its shutdown
+    if (!server_config.tt_snapshot.empty()) {
+        if (search::tt.load(server_config.tt_snapshot)) {
+            std::cout << "Transposition table loaded from " << server_config.tt_snapshot << ".\n";
+        }
+        save_tt_on_shutdown(server_config.tt_snapshot);
+    }
+
     try {
         auto const address = net::ip::make_address("0.0.0.0");
-        unsigned short port = 18080;
+        unsigned short port = server_config.port;
 
         net::io_context ioc{1};
         tcp::acceptor acceptor{ioc, {address, port}};
         tcp::socket socket{ioc};
 
-        std::cout << "Server is running on port 18080.\n";
+        std::cout << "Server is running on port " << port << " (hash " << search::tt.size_mb() << " MB, "
+                  << search::thread_count << (search::thread_count == 1 ? " thread" : " threads") << ").\n";
 
         for (;;) {
             // Wait for a connection
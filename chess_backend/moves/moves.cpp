@@ -31,22 +31,21 @@ int find_king_square(piece::Color color, const board::Board &board) {
 }
 
 bool is_square_attacked_after_move(int square, piece::Color attacker_color, const Move &move, const board::Board &board, game_state::GameState &game_state) {
-    // Create a copy of the board
-    board::Board temp_board = board.copy();
-
-    // Update the temporary board with the move
-    temp_board.remove_piece(move.from, move.color);
-    temp_board.add_piece(move.to, move.piece_type, move.color);
-
-    // If the move is a capture, remove the captured piece
-    if (temp_board.is_capture(move.to, move.color)) {
-        temp_board.remove_piece(move.to, utils::opposite_color(move.color));
+    // Play the move on the occupancy only: sliders see through the vacated square
+    bit::Bitboard from_mask = 1ULL << move.from;
+    bit::Bitboard to_mask = 1ULL << move.to;
+    bit::Bitboard occupancy = (board.get_occupied_squares() & ~from_mask) | to_mask;
+
+    // A captured piece no longer attacks, including a pawn taken en passant
+    bit::Bitboard enemies = (move.color == piece::Color::WHITE) ? board.get_black_pieces() : board.get_white_pieces();
+    enemies &= ~to_mask;
+    if (move.move_type == moves::EN_PASSANT) {
+        bit::Bitboard captured_pawn = (move.color == piece::Color::WHITE) ? (to_mask >> 8) : (to_mask << 8);
+        occupancy &= ~captured_pawn;
+        enemies &= ~captured_pawn;
     }
 
-    game_state::GameState temp_game_state = game_state::GameState(temp_board, move.color, false, false, false, false, -1, 0, 0);
-
-    // Now check if the square is attacked on this updated board
-    return temp_game_state.is_square_attacked(square, move.color);
+    return (board.attackers_to(square, occupancy) & enemies) != 0;
 }
 
 bool Move::operator==(const Move &other) const {
@@ -297,6 +296,51 @@ std::vector<Move> generate_legal_moves(piece::Color color, game_state::GameState
     return legal_moves;
 }
 
+std::vector<Move> generate_legal_captures(piece::Color color, game_state::GameState &game_state) {
+    std::vector<Move> captures;
+    captures.reserve(32);
+
+    const board::Board &board = game_state.get_board();
+    int king_square = find_king_square(color, board);
+    bit::Bitboard opponent_occupancy = (color == piece::Color::WHITE) ? board.get_black_pieces() : board.get_white_pieces();
+    bit::Bitboard promotion_rank = (color == piece::Color::WHITE) ? board::rank_8 : board::rank_1;
+    bit::Bitboard en_passant = (game_state.en_passant_square != -1) ? (1ULL << game_state.en_passant_square) : 0ULL;
+
+    for (auto type : {piece::Type::QUEEN, piece::Type::ROOK, piece::Type::KING, piece::Type::BISHOP, piece::Type::KNIGHT, piece::Type::PAWN}) {
+        bit::Bitboard piece_bitboard = board.get_pieces(type, color);
+        while (piece_bitboard) {
+            int from_square = __builtin_ffsll(piece_bitboard) - 1;
+            piece_bitboard &= piece_bitboard - 1;
+
+            bit::Bitboard targets = opponent_occupancy;
+            if (type == piece::Type::PAWN) {
+                targets |= en_passant | promotion_rank;
+            }
+            bit::Bitboard attack_bitboard = get_piece_moves(from_square, type, color, board, game_state) & targets;
+
+            while (attack_bitboard) {
+                int to = __builtin_ctzll(attack_bitboard);
+                attack_bitboard &= attack_bitboard - 1;
+
+                Move move(from_square, to, type, color, moves::CAPTURE);
+                if (type == piece::Type::PAWN && (promotion_rank & (1ULL << to))) {
+                    move.move_type = moves::PROMOTION;
+                    move.promotion = piece::Type::QUEEN;
+                } else if (type == piece::Type::PAWN && (en_passant & (1ULL << to))) {
+                    move.move_type = moves::EN_PASSANT;
+                }
+
+                int checked_square = (type == piece::Type::KING) ? to : king_square;
+                if (!is_square_attacked_after_move(checked_square, color, move, board, game_state)) {
+                    captures.push_back(move);
+                }
+            }
+        }
+    }
+
+    return captures;
+}
+
 std::string to_string(const Move &move) {
     // Convert individual fields to string representations
     std::string from_str = square::int_position_to_string(move.from);
@@ -314,5 +358,163 @@ std::string to_string(const Move &move) {
     return result;
 }
 
+std::string to_uci(const Move &move) {
+    if (move.is_null()) {
+        return "0000";
+    }
+
+    std::string result = square::int_position_to_string(move.from) + square::int_position_to_string(move.to);
+
+    switch (move.promotion) {
+    case piece::Type::QUEEN:
+        return result + "q";
+    case piece::Type::ROOK:
+        return result + "r";
+    case piece::Type::BISHOP:
+        return result + "b";
+    case piece::Type::KNIGHT:
+        return result + "n";
+    default:
+        return result;
+    }
+}
+
+Move from_uci(const std::string &text, game_state::GameState &game_state) {
+    for (const auto &move : generate_legal_moves(game_state.turn, game_state)) {
+        if (to_uci(move) == text) {
+            return move;
+        }
+    }
+    return Move();
+}
+
+std::string to_san(const Move &move, game_state::GameState &game_state) {
+    if (move.is_null()) {
+        return "--";
+    }
+
+    static const char piece_letters[] = {'P', 'N', 'B', 'R', 'Q', 'K'};
+    const board::Board &board = game_state.get_board();
+    std::string san;
+
+    if (move.move_type == moves::CASTLING) {
+        san = (move.to % 8 == 6) ? "O-O" : "O-O-O";
+    } else {
+        std::string to = square::int_position_to_string(move.to);
+        bool capture = move.move_type == moves::EN_PASSANT || board.is_capture(move.to, move.color);
+
+        if (move.piece_type == piece::Type::PAWN) {
+            if (capture) {
+                san += static_cast<char>('a' + move.from % 8);
+                san += 'x';
+            }
+            san += to;
+            if (move.promotion != piece::Type::EMPTY) {
+                san += '=';
+                san += piece_letters[move.promotion];
+            }
+        } else {
+            san += piece_letters[move.piece_type];
+
+            // Name the origin file, else rank, else both, when another piece of the type can reach the square
+            bool ambiguous = false, same_file = false, same_rank = false;
+            for (const auto &other : generate_legal_moves(game_state.turn, game_state)) {
+                if (other.piece_type == move.piece_type && other.to == move.to && other.from != move.from) {
+                    ambiguous = true;
+                    same_file |= other.from % 8 == move.from % 8;
+                    same_rank |= other.from / 8 == move.from / 8;
+                }
+            }
+            if (ambiguous) {
+                std::string from = square::int_position_to_string(move.from);
+                san += !same_file ? from.substr(0, 1) : !same_rank ? from.substr(1, 1) : from;
+            }
+
+            if (capture) {
+                san += 'x';
+            }
+            san += to;
+        }
+    }
+
+    if (game_state.make_move(move)) {
+        if (game_state.is_in_check(game_state.turn)) {
+            san += generate_legal_moves(game_state.turn, game_state).empty() ? '#' : '+';
+        }
+    }
+    game_state.unmake_move();
+
+    return san;
+}
+
+Move from_san(const std::string &text, game_state::GameState &game_state) {
+    std::string san = text;
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+        san.pop_back();
+    }
+    std::vector<Move> legal_moves = generate_legal_moves(game_state.turn, game_state);
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        int to_file = (san.size() == 3) ? 6 : 2;
+        for (const auto &move : legal_moves) {
+            if (move.move_type == moves::CASTLING && move.to % 8 == to_file) {
+                return move;
+            }
+        }
+        return Move();
+    }
+
+    piece::Type piece_type = piece::Type::PAWN;
+    static const std::string piece_letters = "NBRQK";
+    if (!san.empty() && piece_letters.find(san[0]) != std::string::npos) {
+        piece_type = static_cast<piece::Type>(piece::Type::KNIGHT + piece_letters.find(san[0]));
+        san.erase(0, 1);
+    }
+
+    // Promotion, written "e8=Q" or "e8Q"
+    piece::Type promotion = piece::Type::EMPTY;
+    if (!san.empty() && piece_letters.find(san.back()) != std::string::npos && san.back() != 'K') {
+        promotion = static_cast<piece::Type>(piece::Type::KNIGHT + piece_letters.find(san.back()));
+        san.pop_back();
+        if (!san.empty() && san.back() == '=') {
+            san.pop_back();
+        }
+    }
+
+    // What remains is [from file][from rank][x]<to square>
+    if (san.size() < 2) {
+        return Move();
+    }
+    std::string to_text = san.substr(san.size() - 2);
+    if (to_text[0] < 'a' || to_text[0] > 'h' || to_text[1] < '1' || to_text[1] > '8') {
+        return Move();
+    }
+    int to = square::string_position_to_int(to_text);
+
+    int from_file = -1, from_rank = -1;
+    for (size_t i = 0; i + 2 < san.size(); ++i) {
+        if (san[i] >= 'a' && san[i] <= 'h') {
+            from_file = san[i] - 'a';
+        } else if (san[i] >= '1' && san[i] <= '8') {
+            from_rank = san[i] - '1';
+        } else if (san[i] != 'x') {
+            return Move();
+        }
+    }
+
+    Move found;
+    for (const auto &move : legal_moves) {
+        if (move.piece_type != piece_type || move.to != to || move.promotion != promotion ||
+            (from_file != -1 && move.from % 8 != from_file) || (from_rank != -1 && move.from / 8 != from_rank)) {
+            continue;
+        }
+        if (!found.is_null()) {
+            return Move(); // Ambiguous
+        }
+        found = move;
+    }
+    return found;
+}
+
 } // namespace moves
 } // namespace chess_engine
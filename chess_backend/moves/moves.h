@@ -94,8 +94,25 @@ std::vector<Move> generate_pseudo_legal_moves(piece::Color color, const board::B
 // Get only legal moves, no moves that leave the king in check are left here.
 std::vector<moves::Move> generate_legal_moves(piece::Color color, game_state::GameState &game_state);
 
+// Legal captures (en passant included) and queen promotions only, for quiescence search.
+// Quiet moves are never generated, so none of them pays for a legality check.
+std::vector<moves::Move> generate_legal_captures(piece::Color color, game_state::GameState &game_state);
+
 std::string to_string(const Move &move);
 
+// Long algebraic (UCI) notation of a move, e.g. "e2e4" or "e7e8q".
+std::string to_uci(const Move &move);
+
+// The legal move written in UCI notation in this position, or a null move if there is none.
+Move from_uci(const std::string &text, game_state::GameState &game_state);
+
+// Standard algebraic notation of a legal move in this position, e.g. "Nbd7", "exd6", "O-O" or "e8=Q+".
+std::string to_san(const Move &move, game_state::GameState &game_state);
+
+// The legal move written in standard algebraic notation in this position, or a null move if there
+// is none. Check marks and annotations ("+", "#", "!", "?") are ignored; "0-0" is read as "O-O".
+Move from_san(const std::string &text, game_state::GameState &game_state);
+
 } // namespace moves
 } // namespace chess_engine
 
@@ -225,6 +225,11 @@ bit::Bitboard get_moves(int from, piece::Color color, const board::Board &board)
     return attack_table[from][index];
 }
 
+bit::Bitboard get_attacks(int from, bit::Bitboard occupancy) {
+    int index = magic_hash(occupancy & diagonal_moves[from], magic_numbers[from], shift_values[from]);
+    return attack_table[from][index];
+}
+
 } // namespace diagonal
 } // namespace moves
 } // namespace chess_engine
\ No newline at end of file
@@ -12,6 +12,9 @@ namespace diagonal {
 
 bit::Bitboard get_moves(int from, piece::Color color, const board::Board &board);
 
+// Squares attacked from a square given an arbitrary occupancy (e.g. with pieces lifted for SEE)
+bit::Bitboard get_attacks(int from, bit::Bitboard occupancy);
+
 } // namespace diagonal
 } // namespace moves
 } // namespace chess_engine
@@ -238,6 +238,11 @@ bit::Bitboard get_moves(int from, piece::Color color, const board::Board &board)
     return attack_table[from][index];
 }
 
+bit::Bitboard get_attacks(int from, bit::Bitboard occupancy) {
+    int index = magic_hash(occupancy & straight_moves[from], magic_numbers[from], shift_values[from]);
+    return attack_table[from][index];
+}
+
 } // namespace straight
 } // namespace moves
 } // namespace chess_engine
\ No newline at end of file
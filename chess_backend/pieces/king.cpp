@@ -25,13 +25,7 @@ bit::Bitboard get_moves(int from, piece::Color color, const board::Board &board,
     bit::Bitboard valid_squares = (color == piece::Color::WHITE) ? ~board.get_white_pieces() : ~board.get_black_pieces();
     bit::Bitboard legal_moves = available_king_moves & valid_squares;
 
-    int opponents_king_position = __builtin_ffsll(board.get_king(utils::opposite_color(color))) - 1;
-    bit::Bitboard opponents_king_attacks = king_moves[opponents_king_position];
-
-    bit::Bitboard opponents_pawn_attacks = pawn::get_possible_attacks(utils::opposite_color(color), game_state.get_board().get_pawns(utils::opposite_color(color)));
-
-    bit::Bitboard opponent_attack_mask_without_king = moves::get_all_piece_moves(utils::opposite_color(color), board, game_state, true);
-    bit::Bitboard opponent_attack_mask = opponent_attack_mask_without_king | opponents_king_attacks | opponents_pawn_attacks;
+    bit::Bitboard opponent_attack_mask = game_state.attack_map(utils::opposite_color(color));
 
     bit::Bitboard safe_moves = legal_moves & ~opponent_attack_mask;
 
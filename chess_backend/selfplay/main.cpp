@@ -0,0 +1,163 @@
+#include "../generator/search.h"
+#include "../generator/zobrist.h"
+#include "selfplay.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chess_engine;
+
+// Plays two engine configurations against each other in-process and stops as soon as an
+// SPRT on their Elo difference decides.
+//
+// Usage: chess_selfplay [options]
+//   --first <options>, --second <options>
+//                       Engine options as comma-separated key=value pairs: name, depth,
+//                       nodes, movetime (ms per move) and hash (MB)
+//   --depth <n>, --nodes <n>, --movetime <ms>
+//                       Limits shared by both engines unless overridden (default: 20000 nodes)
+//   --openings <file>   EPD file of starting positions (default: a few built-in ones)
+//   --games <n>         Upper bound on games (default 1000)
+//   --concurrency <n>   Games played at once (default: one per hardware thread)
+//   --max-plies <n>     Longer games are adjudicated as draws (default 400)
+//   --elo0 <elo>, --elo1 <elo>, --alpha <p>, --beta <p>
+//                       SPRT hypotheses and error rates (default 0, 5, 0.05, 0.05)
+//   --no-sprt           Play all games
+//   --pgn <file>        Write every counted game
+
+const std::vector<std::string> DEFAULT_OPENINGS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+    "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+    "rnbqkbnr/pppp1ppp/4p3/8/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2",
+    "rnbqkbnr/ppp1pppp/8/3p4/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 0 2",
+    "rnbqkb1r/pppppppp/5n2/8/3P4/8/PPP1PPPP/RNBQKBNR w KQkq - 1 2",
+    "rnbqkbnr/pppppppp/8/8/2P5/8/PP1PPPPP/RNBQKBNR b KQkq - 0 1",
+    "rnbqkbnr/pppppppp/8/8/8/5N2/PPPPPPPP/RNBQKB1R b KQkq - 1 1",
+};
+
+// Apply "key=value,key=value" to an engine configuration
+void parse_engine_options(const std::string &text, selfplay::EngineConfig &engine) {
+    std::istringstream pairs(text);
+    std::string pair;
+    while (std::getline(pairs, pair, ',')) {
+        size_t equals = pair.find('=');
+        if (equals == std::string::npos) {
+            throw std::invalid_argument("expected key=value: " + pair);
+        }
+        std::string key = pair.substr(0, equals);
+        std::string value = pair.substr(equals + 1);
+
+        if (key == "name") {
+            engine.name = value;
+        } else if (key == "depth") {
+            engine.limits.depth = std::stoi(value);
+        } else if (key == "nodes") {
+            engine.limits.nodes = std::stoull(value);
+        } else if (key == "movetime") {
+            engine.limits.movetime_ms = std::stoll(value);
+        } else if (key == "hash") {
+            engine.hash_mb = std::max(1, std::stoi(value));
+        } else {
+            throw std::invalid_argument("unknown engine option: " + key);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    zobrist::init_zobrist_keys();
+
+    search::SearchLimits shared_limits;
+    shared_limits.depth = search::MAX_DEPTH;
+    shared_limits.nodes = 20000;
+
+    std::string first_options, second_options, openings_path;
+    selfplay::MatchOptions options;
+    options.concurrency = std::max(1u, std::thread::hardware_concurrency());
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--no-sprt") {
+                options.use_sprt = false;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            std::string value = argv[++i];
+
+            if (arg == "--first") {
+                first_options = value;
+            } else if (arg == "--second") {
+                second_options = value;
+            } else if (arg == "--depth") {
+                shared_limits.depth = std::stoi(value);
+                shared_limits.nodes = 0;
+            } else if (arg == "--nodes") {
+                shared_limits.nodes = std::stoull(value);
+            } else if (arg == "--movetime") {
+                shared_limits.movetime_ms = std::stoll(value);
+                shared_limits.nodes = 0;
+            } else if (arg == "--openings") {
+                openings_path = value;
+            } else if (arg == "--games") {
+                options.games = std::stoi(value);
+            } else if (arg == "--concurrency") {
+                options.concurrency = std::max(1, std::stoi(value));
+            } else if (arg == "--max-plies") {
+                options.max_plies = std::stoi(value);
+            } else if (arg == "--elo0") {
+                options.sprt.elo0 = std::stod(value);
+            } else if (arg == "--elo1") {
+                options.sprt.elo1 = std::stod(value);
+            } else if (arg == "--alpha") {
+                options.sprt.alpha = std::stod(value);
+            } else if (arg == "--beta") {
+                options.sprt.beta = std::stod(value);
+            } else if (arg == "--pgn") {
+                options.pgn_path = value;
+            } else {
+                throw std::invalid_argument("unknown argument: " + arg);
+            }
+        }
+
+        selfplay::EngineConfig first{"first", shared_limits};
+        selfplay::EngineConfig second{"second", shared_limits};
+        parse_engine_options(first_options, first);
+        parse_engine_options(second_options, second);
+
+        options.openings = openings_path.empty() ? DEFAULT_OPENINGS : selfplay::load_openings(openings_path);
+
+        std::printf("%s vs %s, %zu openings, %d games at most, %d at once\n", first.name.c_str(), second.name.c_str(),
+                    options.openings.size(), options.games, options.concurrency);
+        if (options.use_sprt) {
+            std::printf("SPRT elo0 %.1f elo1 %.1f, LLR bounds [%.2f, %.2f]\n", options.sprt.elo0, options.sprt.elo1,
+                        options.sprt.lower_bound(), options.sprt.upper_bound());
+        }
+
+        selfplay::MatchResult result = selfplay::run_match(first, second, options, [](const selfplay::GameRecord &game, const selfplay::MatchResult &totals) {
+            std::printf("game %4d: %-8s %s vs %s (%s)  W %d D %d L %d  elo %+.1f +- %.1f  LLR %.2f\n", totals.games(),
+                        game.result == selfplay::Result::DRAW ? "1/2-1/2" : game.result == selfplay::Result::WHITE_WINS ? "1-0" : "0-1",
+                        game.white.c_str(), game.black.c_str(), game.termination.c_str(), totals.wins, totals.draws, totals.losses,
+                        totals.elo(), totals.elo_error(), totals.llr);
+            std::fflush(stdout);
+        });
+
+        const char *verdict = result.decision == selfplay::Decision::ACCEPT_H1   ? "H1 accepted"
+                              : result.decision == selfplay::Decision::ACCEPT_H0 ? "H0 accepted"
+                                                                                 : "no decision";
+        std::printf("%d games: W %d D %d L %d, elo %+.1f +- %.1f, LLR %.2f, %s\n", result.games(), result.wins, result.draws,
+                    result.losses, result.elo(), result.elo_error(), result.llr, options.use_sprt ? verdict : "SPRT off");
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "chess_selfplay: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,356 @@
+#include "selfplay.h"
+#include "../generator/transposition.h"
+#include "../generator/zobrist.h"
+#include "../moves/moves.h"
+#include "../structure/game_state.h"
+#include "../utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace chess_engine {
+namespace selfplay {
+
+// Times the current position occurred before, since the last capture or pawn move
+int repetitions(const std::vector<uint64_t> &keys, uint64_t hash, int halfmove_clock) {
+    int reachable = std::min<int>(halfmove_clock, static_cast<int>(keys.size()));
+    int count = 0;
+    for (int distance = 2; distance <= reachable; distance += 2) {
+        if (keys[keys.size() - distance] == hash) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Bare kings, or a single bishop or knight against a bare king
+bool insufficient_material(const board::Board &board) {
+    bit::Bitboard heavy = 0ULL;
+    bit::Bitboard minors = 0ULL;
+    for (piece::Color color : {piece::Color::WHITE, piece::Color::BLACK}) {
+        heavy |= board.get_pawns(color) | board.get_rooks(color) | board.get_queens(color);
+        minors |= board.get_bishops(color) | board.get_knights(color);
+    }
+    return heavy == 0 && __builtin_popcountll(minors) <= 1;
+}
+
+GameRecord play_game(const std::string &fen, const EngineConfig &white, const EngineConfig &black, int max_plies) {
+    GameRecord game;
+    game.opening_fen = fen;
+    game.white = white.name;
+    game.black = black.name;
+
+    game_state::GameState state = game_state::set_game_state(fen);
+
+    transposition::TranspositionTable white_table(white.hash_mb);
+    transposition::TranspositionTable black_table(black.hash_mb);
+    const EngineConfig *engines[2] = {&white, &black};
+    search::SearchState search_states[2];
+    search_states[piece::Color::WHITE].table = &white_table;
+    search_states[piece::Color::BLACK].table = &black_table;
+
+    for (int ply = 0;; ++ply) {
+        piece::Color side = state.turn;
+        Result side_loses = (side == piece::Color::WHITE) ? Result::BLACK_WINS : Result::WHITE_WINS;
+
+        std::vector<moves::Move> legal_moves = moves::generate_legal_moves(side, state);
+        if (legal_moves.empty()) {
+            bool mated = state.is_in_check(side);
+            game.result = mated ? side_loses : Result::DRAW;
+            game.termination = mated ? "checkmate" : "stalemate";
+            break;
+        }
+        if (state.is_draw_by_fifty_move_rule()) {
+            game.termination = "fifty-move rule";
+            break;
+        }
+        if (repetitions(search_states[0].key_history, zobrist::compute_hash(state), state.halfmove_clock) >= 2) {
+            game.termination = "threefold repetition";
+            break;
+        }
+        if (insufficient_material(state.get_board())) {
+            game.termination = "insufficient material";
+            break;
+        }
+        if (ply >= max_plies) {
+            game.termination = "move limit";
+            break;
+        }
+
+        moves::Move move = search::find_best_move(engines[side]->limits, side, state, nullptr, nullptr, &search_states[side]);
+        if (std::find(legal_moves.begin(), legal_moves.end(), move) == legal_moves.end()) {
+            game.result = side_loses;
+            game.termination = "illegal move " + moves::to_uci(move);
+            break;
+        }
+
+        game.moves.push_back(moves::to_san(move, state));
+        for (auto &search_state : search_states) {
+            search_state.push_position(state);
+        }
+        state.make_move(move);
+    }
+
+    return game;
+}
+
+std::string result_to_string(Result result) {
+    switch (result) {
+    case Result::WHITE_WINS:
+        return "1-0";
+    case Result::BLACK_WINS:
+        return "0-1";
+    default:
+        return "1/2-1/2";
+    }
+}
+
+std::string to_pgn(const GameRecord &game) {
+    std::time_t now = std::time(nullptr);
+    std::tm utc;
+    gmtime_r(&now, &utc);
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y.%m.%d", &utc);
+
+    std::string result = result_to_string(game.result);
+    std::string termination = (game.termination == "move limit")                ? "adjudication"
+                              : (game.termination.rfind("illegal move", 0) == 0) ? "rules infraction"
+                                                                                 : "normal";
+
+    std::ostringstream pgn;
+    pgn << "[Event \"Self-play\"]\n";
+    pgn << "[Site \"chess_selfplay\"]\n";
+    pgn << "[Date \"" << date << "\"]\n";
+    pgn << "[Round \"" << game.round << "\"]\n";
+    pgn << "[White \"" << game.white << "\"]\n";
+    pgn << "[Black \"" << game.black << "\"]\n";
+    pgn << "[Result \"" << result << "\"]\n";
+    pgn << "[FEN \"" << game.opening_fen << "\"]\n";
+    pgn << "[SetUp \"1\"]\n";
+    pgn << "[PlyCount \"" << game.moves.size() << "\"]\n";
+    pgn << "[Termination \"" << termination << "\"]\n\n";
+
+    // Move numbers continue from the opening position
+    game_state::GameState start = game_state::set_game_state(game.opening_fen);
+    int move_number = std::max(1, start.fullmove_number);
+    bool white_to_move = start.turn == piece::Color::WHITE;
+
+    std::vector<std::string> tokens;
+    for (size_t i = 0; i < game.moves.size(); ++i) {
+        if (white_to_move) {
+            tokens.push_back(std::to_string(move_number) + ".");
+        } else if (i == 0) {
+            tokens.push_back(std::to_string(move_number) + "...");
+        }
+        tokens.push_back(game.moves[i]);
+        if (!white_to_move) {
+            ++move_number;
+        }
+        white_to_move = !white_to_move;
+    }
+    tokens.push_back("{" + game.termination + "}");
+    tokens.push_back(result);
+
+    // Movetext lines stay under 80 characters
+    size_t line_length = 0;
+    for (const auto &token : tokens) {
+        if (line_length > 0 && line_length + 1 + token.size() > 79) {
+            pgn << "\n";
+            line_length = 0;
+        } else if (line_length > 0) {
+            pgn << " ";
+            ++line_length;
+        }
+        pgn << token;
+        line_length += token.size();
+    }
+    pgn << "\n\n";
+
+    return pgn.str();
+}
+
+std::vector<std::string> load_openings(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    std::vector<std::string> openings;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::vector<std::string> parts;
+        std::string field;
+        while (parts.size() < 6 && fields >> field) {
+            parts.push_back(field);
+        }
+        if (parts.size() < 4 || parts[0][0] == '#') {
+            continue;
+        }
+
+        // EPD has no move counters; operations such as "bm" may follow the fourth field instead
+        bool has_counters = parts.size() == 6 && utils::is_number(parts[4]) && utils::is_number(parts[5]);
+        std::string fen = parts[0] + " " + parts[1] + " " + parts[2] + " " + parts[3] + " " +
+                          (has_counters ? parts[4] + " " + parts[5] : "0 1");
+
+        // Checked here, since the games that start from it run on worker threads
+        try {
+            game_state::set_game_state(fen);
+        } catch (const std::invalid_argument &e) {
+            throw std::invalid_argument(path + ": invalid opening " + fen + ": " + e.what());
+        }
+        openings.push_back(fen);
+    }
+    return openings;
+}
+
+// Expected score of the stronger side at an Elo difference
+double expected_score(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double score_to_elo(double score) {
+    score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Mean score and variance of a single game's score
+void score_moments(int wins, int draws, int losses, double &mean, double &variance) {
+    double games = wins + draws + losses;
+    mean = (wins + 0.5 * draws) / games;
+    variance = (wins * std::pow(1.0 - mean, 2) + draws * std::pow(0.5 - mean, 2) + losses * std::pow(mean, 2)) / games;
+}
+
+double Sprt::llr(int wins, int draws, int losses) const {
+    int games = wins + draws + losses;
+    if (games == 0) {
+        return 0.0;
+    }
+
+    double mean, variance;
+    score_moments(wins, draws, losses, mean, variance);
+    if (variance <= 0.0) {
+        return 0.0;
+    }
+
+    double s0 = expected_score(elo0);
+    double s1 = expected_score(elo1);
+    return games * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+}
+
+double Sprt::lower_bound() const {
+    return std::log(beta / (1.0 - alpha));
+}
+
+double Sprt::upper_bound() const {
+    return std::log((1.0 - beta) / alpha);
+}
+
+double MatchResult::elo() const {
+    if (games() == 0) {
+        return 0.0;
+    }
+    double mean, variance;
+    score_moments(wins, draws, losses, mean, variance);
+    return score_to_elo(mean);
+}
+
+double MatchResult::elo_error() const {
+    if (games() == 0) {
+        return 0.0;
+    }
+    double mean, variance;
+    score_moments(wins, draws, losses, mean, variance);
+    double margin = 1.96 * std::sqrt(variance / games());
+    return (score_to_elo(mean + margin) - score_to_elo(mean - margin)) / 2.0;
+}
+
+MatchResult run_match(const EngineConfig &first, const EngineConfig &second, const MatchOptions &options,
+                      const std::function<void(const GameRecord &, const MatchResult &)> &on_game) {
+    if (options.openings.empty()) {
+        throw std::invalid_argument("no opening positions");
+    }
+
+    std::ofstream pgn;
+    if (!options.pgn_path.empty()) {
+        pgn.open(options.pgn_path);
+        if (!pgn) {
+            throw std::runtime_error("cannot write " + options.pgn_path);
+        }
+    }
+
+    MatchResult result;
+    std::mutex result_mutex;
+    std::atomic<int> next_game{0};
+    std::atomic<bool> decided{false};
+
+    auto worker = [&]() {
+        while (!decided.load(std::memory_order_relaxed)) {
+            int index = next_game.fetch_add(1);
+            if (index >= options.games) {
+                return;
+            }
+
+            // Consecutive games share an opening with colors swapped, which cancels most of its bias
+            const std::string &opening = options.openings[(index / 2) % options.openings.size()];
+            bool first_is_white = index % 2 == 0;
+            GameRecord game = first_is_white ? play_game(opening, first, second, options.max_plies)
+                                             : play_game(opening, second, first, options.max_plies);
+            game.round = index + 1;
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+
+            // Games still running when the test decided are not counted
+            if (decided.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            if (game.result == Result::DRAW) {
+                ++result.draws;
+            } else if ((game.result == Result::WHITE_WINS) == first_is_white) {
+                ++result.wins;
+            } else {
+                ++result.losses;
+            }
+
+            if (options.use_sprt) {
+                result.llr = options.sprt.llr(result.wins, result.draws, result.losses);
+                if (result.llr >= options.sprt.upper_bound()) {
+                    result.decision = Decision::ACCEPT_H1;
+                } else if (result.llr <= options.sprt.lower_bound()) {
+                    result.decision = Decision::ACCEPT_H0;
+                }
+                if (result.decision != Decision::NONE) {
+                    decided.store(true, std::memory_order_relaxed);
+                }
+            }
+
+            if (pgn.is_open()) {
+                pgn << to_pgn(game) << std::flush;
+            }
+            if (on_game) {
+                on_game(game, result);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::max(1, options.concurrency); ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto &thread : workers) {
+        thread.join();
+    }
+
+    return result;
+}
+
+} // namespace selfplay
+} // namespace chess_engine
@@ -0,0 +1,103 @@
+#ifndef CHESS_ENGINE_SELFPLAY_H
+#define CHESS_ENGINE_SELFPLAY_H
+
+#include "../generator/search.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chess_engine {
+namespace selfplay {
+
+// One side of a match: its name in the PGN and the runtime options of its searches
+struct EngineConfig {
+    std::string name;
+    search::SearchLimits limits; // Applied to every move
+    size_t hash_mb = 16;         // Private table per game, so concurrent games do not share entries
+};
+
+enum class Result {
+    WHITE_WINS,
+    BLACK_WINS,
+    DRAW
+};
+
+struct GameRecord {
+    int round = 0;
+    std::string opening_fen;
+    std::string white;
+    std::string black;
+    std::vector<std::string> moves; // Standard algebraic notation
+    Result result = Result::DRAW;
+    std::string termination; // e.g. "checkmate", "threefold repetition"
+};
+
+// Game-ending rules, also used by datagen: how often the current position occurred before
+// (keys of earlier positions, oldest first), and whether neither side can mate
+int repetitions(const std::vector<uint64_t> &keys, uint64_t hash, int halfmove_clock);
+bool insufficient_material(const board::Board &board);
+
+// Play one game from the FEN, each engine searching with its own table and game history
+GameRecord play_game(const std::string &fen, const EngineConfig &white, const EngineConfig &black, int max_plies);
+
+std::string to_pgn(const GameRecord &game);
+
+// Opening positions from an EPD file, one per line, completed to full FENs
+std::vector<std::string> load_openings(const std::string &path);
+
+// Sequential probability ratio test of H0: elo = elo0 against H1: elo = elo1, on the
+// logistic Elo difference, using the normal approximation of the trinomial (W/D/L) model
+struct Sprt {
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05; // False positive rate
+    double beta = 0.05;  // False negative rate
+
+    double llr(int wins, int draws, int losses) const;
+    double lower_bound() const; // Accept H0 at or below
+    double upper_bound() const; // Accept H1 at or above
+};
+
+enum class Decision {
+    NONE,
+    ACCEPT_H0,
+    ACCEPT_H1
+};
+
+struct MatchOptions {
+    std::vector<std::string> openings; // Each one is played twice, with colors swapped
+    int games = 1000;                  // Upper bound when the SPRT does not decide first
+    int concurrency = 1;
+    int max_plies = 400; // Longer games are adjudicated as draws
+    bool use_sprt = true;
+    Sprt sprt;
+    std::string pgn_path; // Empty: no PGN
+};
+
+// Running totals from the first engine's point of view
+struct MatchResult {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    double llr = 0.0;
+    Decision decision = Decision::NONE;
+
+    int games() const {
+        return wins + draws + losses;
+    }
+
+    // Elo difference estimate and its 95% confidence half-width
+    double elo() const;
+    double elo_error() const;
+};
+
+// Play first against second until the game budget is spent or the SPRT decides. on_game is
+// called after every finished game, one call at a time.
+MatchResult run_match(const EngineConfig &first, const EngineConfig &second, const MatchOptions &options,
+                      const std::function<void(const GameRecord &, const MatchResult &)> &on_game = nullptr);
+
+} // namespace selfplay
+} // namespace chess_engine
+
+#endif
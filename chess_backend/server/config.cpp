@@ -0,0 +1,153 @@
+#include "config.h"
+#include "../utils.h"
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace chess_engine {
+namespace config {
+
+struct Setting {
+    const char *key;
+    const char *environment;
+    std::function<void(Config &, const std::string &)> set;
+    std::function<std::string(const Config &)> get;
+};
+
+// Whole-string numbers only, so that "64MB" or "1e3" are rejected rather than misread
+long long parse_integer(const std::string &key, const std::string &value, long long min, long long max) {
+    size_t used = 0;
+    long long number = 0;
+    try {
+        number = std::stoll(value, &used);
+    } catch (const std::exception &e) {
+        used = 0;
+    }
+    if (used == 0 || used != value.size() || number < min || number > max) {
+        throw std::invalid_argument("invalid value for " + key + ": " + value);
+    }
+    return number;
+}
+
+const std::vector<Setting> &settings() {
+    static const std::vector<Setting> all = {
+        {"port", "CHESS_PORT",
+         [](Config &c, const std::string &v) { c.port = static_cast<unsigned short>(parse_integer("port", v, 1, 65535)); },
+         [](const Config &c) { return std::to_string(c.port); }},
+        {"hash", "CHESS_HASH_MB",
+         [](Config &c, const std::string &v) { c.hash_mb = static_cast<size_t>(parse_integer("hash", v, 1, MAX_HASH_MB)); },
+         [](const Config &c) { return std::to_string(c.hash_mb); }},
+        {"threads", "CHESS_THREADS",
+         [](Config &c, const std::string &v) { c.threads = static_cast<int>(parse_integer("threads", v, 1, 1024)); },
+         [](const Config &c) { return std::to_string(c.threads); }},
+        {"depth", "CHESS_DEPTH",
+         [](Config &c, const std::string &v) { c.depth = static_cast<int>(parse_integer("depth", v, 1, 64)); },
+         [](const Config &c) { return std::to_string(c.depth); }},
+        {"movetime", "CHESS_MOVETIME_MS",
+         [](Config &c, const std::string &v) { c.movetime_ms = parse_integer("movetime", v, 0, 24LL * 3600 * 1000); },
+         [](const Config &c) { return std::to_string(c.movetime_ms); }},
+        {"max-search-time", "CHESS_MAX_SEARCH_S",
+         [](Config &c, const std::string &v) { c.max_search_time_s = static_cast<int>(parse_integer("max-search-time", v, 1, 24 * 3600)); },
+         [](const Config &c) { return std::to_string(c.max_search_time_s); }},
+        {"sessions", "CHESS_MAX_SESSIONS",
+         [](Config &c, const std::string &v) { c.max_sessions = static_cast<size_t>(parse_integer("sessions", v, 1, 1 << 20)); },
+         [](const Config &c) { return std::to_string(c.max_sessions); }},
+        {"syzygy-path", "SYZYGY_PATH",
+         [](Config &c, const std::string &v) { c.syzygy_path = v; },
+         [](const Config &c) { return c.syzygy_path; }},
+        {"book", "BOOK_PATH",
+         [](Config &c, const std::string &v) { c.book_path = v; },
+         [](const Config &c) { return c.book_path; }},
+        {"book-max-ply", "BOOK_MAX_PLY",
+         [](Config &c, const std::string &v) { c.book_max_ply = static_cast<int>(parse_integer("book-max-ply", v, 0, 1000)); },
+         [](const Config &c) { return std::to_string(c.book_max_ply); }},
+        {"tt-snapshot", "TT_SNAPSHOT",
+         [](Config &c, const std::string &v) { c.tt_snapshot = v; },
+         [](const Config &c) { return c.tt_snapshot; }},
+        {"eval-file", "CHESS_EVAL_FILE",
+         [](Config &c, const std::string &v) { c.eval_file = v; },
+         [](const Config &c) { return c.eval_file; }},
+    };
+    return all;
+}
+
+void set(Config &config, const std::string &key, const std::string &value) {
+    for (const auto &setting : settings()) {
+        if (key == setting.key) {
+            setting.set(config, value);
+            return;
+        }
+    }
+    throw std::invalid_argument("unknown setting: " + key);
+}
+
+void read_file(Config &config, const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::invalid_argument("cannot read config file " + path);
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        line = utils::trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            throw std::invalid_argument(path + ":" + std::to_string(line_number) + ": expected key = value");
+        }
+        set(config, utils::trim(line.substr(0, equals)), utils::trim(line.substr(equals + 1)));
+    }
+}
+
+Config load(int argc, char **argv) {
+    // The command line is parsed first to find the config file, and applied last
+    std::vector<std::pair<std::string, std::string>> options;
+    std::string config_path;
+    if (const char *path = std::getenv("CHESS_CONFIG")) {
+        config_path = path;
+    }
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0 || i + 1 >= argc) {
+            throw std::invalid_argument("expected --key value, got " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--config") {
+            config_path = value;
+        } else {
+            options.emplace_back(arg.substr(2), value);
+        }
+    }
+
+    Config config;
+    if (!config_path.empty()) {
+        read_file(config, config_path);
+    }
+    for (const auto &setting : settings()) {
+        if (const char *value = std::getenv(setting.environment)) {
+            setting.set(config, value);
+        }
+    }
+    for (const auto &option : options) {
+        set(config, option.first, option.second);
+    }
+    return config;
+}
+
+std::string to_string(const Config &config) {
+    std::ostringstream out;
+    for (const auto &setting : settings()) {
+        out << setting.key << " = " << setting.get(config) << "\n";
+    }
+    return out.str();
+}
+
+} // namespace config
+} // namespace chess_engine
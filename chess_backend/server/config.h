@@ -0,0 +1,58 @@
+#ifndef CHESS_ENGINE_CONFIG_H
+#define CHESS_ENGINE_CONFIG_H
+
+#include "../generator/book.h"
+#include "../generator/search.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace chess_engine {
+namespace config {
+
+// Server settings. Each one is read from, in increasing priority: its default, a config file of
+// "key = value" lines, its environment variable and the "--key value" command-line option.
+//
+//   key               environment          meaning
+//   port              CHESS_PORT           HTTP port
+//   hash              CHESS_HASH_MB        Transposition table size in MB
+//   threads           CHESS_THREADS        Threads per search (Lazy SMP)
+//   depth             CHESS_DEPTH          Depth of requests that give no limit
+//   movetime          CHESS_MOVETIME_MS    Time limit of requests that give none (0: none)
+//   max-search-time   CHESS_MAX_SEARCH_S   Hard cap on any single search, in seconds
+//   sessions          CHESS_MAX_SESSIONS   Live game sessions kept before the oldest is dropped
+//   syzygy-path       SYZYGY_PATH          Syzygy tablebase directories
+//   book              BOOK_PATH            Polyglot opening book
+//   book-max-ply      BOOK_MAX_PLY         Plies of a game the book is consulted for
+//   tt-snapshot       TT_SNAPSHOT          Table saved on shutdown and loaded on startup
+//   eval-file         CHESS_EVAL_FILE      NNUE network evaluating positions in place of PeSTO
+//
+// The config file is named by --config or CHESS_CONFIG.
+// Largest transposition table accepted from the configuration or POST /hash, in MB
+constexpr size_t MAX_HASH_MB = 1 << 20;
+
+struct Config {
+    unsigned short port = 18080;
+    size_t hash_mb = 64;
+    int threads = 1;
+    int depth = search::DEFAULT_DEPTH;
+    int64_t movetime_ms = 0;
+    int max_search_time_s = 30;
+    size_t max_sessions = 256;
+    std::string syzygy_path;
+    std::string book_path;
+    int book_max_ply = book::DEFAULT_MAX_PLY;
+    std::string tt_snapshot;
+    std::string eval_file;
+};
+
+// Throws std::invalid_argument on an unknown key, a malformed value or an unreadable config file
+Config load(int argc, char **argv);
+
+// One "key = value" line per setting, in the config file format
+std::string to_string(const Config &config);
+
+} // namespace config
+} // namespace chess_engine
+
+#endif
@@ -0,0 +1,157 @@
+#include "metrics.h"
+#include "../generator/statistics.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace chess_engine {
+namespace metrics {
+
+constexpr int ENDPOINT_COUNT = static_cast<int>(Endpoint::COUNT);
+constexpr std::array<const char *, ENDPOINT_COUNT> endpoint_names = {"move", "stream", "metrics", "session", "other"};
+
+// Status classes 1xx-5xx
+constexpr int STATUS_CLASSES = 5;
+
+// Upper bounds of the latency histogram buckets, in seconds (+Inf is implicit)
+constexpr std::array<double, 11> latency_buckets = {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+struct EndpointMetrics {
+    std::array<std::atomic<uint64_t>, STATUS_CLASSES> requests{};
+    std::array<std::atomic<uint64_t>, latency_buckets.size() + 1> buckets{};
+    std::atomic<uint64_t> latency_sum_us{0};
+};
+
+std::array<EndpointMetrics, ENDPOINT_COUNT> endpoints;
+std::atomic<int> connections_in_flight{0};
+
+void connection_opened() {
+    connections_in_flight.fetch_add(1, std::memory_order_relaxed);
+}
+
+void connection_closed() {
+    connections_in_flight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void record_request(Endpoint endpoint, int status, double seconds) {
+    EndpointMetrics &metrics = endpoints[static_cast<int>(endpoint)];
+
+    int status_class = status / 100 - 1;
+    if (status_class >= 0 && status_class < STATUS_CLASSES) {
+        metrics.requests[status_class].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t bucket = 0;
+    while (bucket < latency_buckets.size() && seconds > latency_buckets[bucket]) {
+        ++bucket;
+    }
+    metrics.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    metrics.latency_sum_us.fetch_add(static_cast<uint64_t>(seconds * 1e6), std::memory_order_relaxed);
+}
+
+double ratio(uint64_t part, uint64_t whole) {
+    return whole == 0 ? 0.0 : static_cast<double>(part) / static_cast<double>(whole);
+}
+
+std::string render(int hashfull) {
+    std::ostringstream out;
+
+    out << "# HELP chess_engine_http_requests_total HTTP requests handled.\n";
+    out << "# TYPE chess_engine_http_requests_total counter\n";
+    for (int e = 0; e < ENDPOINT_COUNT; ++e) {
+        for (int c = 0; c < STATUS_CLASSES; ++c) {
+            uint64_t count = endpoints[e].requests[c].load(std::memory_order_relaxed);
+            if (count > 0) {
+                out << "chess_engine_http_requests_total{endpoint=\"" << endpoint_names[e] << "\",code=\"" << c + 1 << "xx\"} " << count << "\n";
+            }
+        }
+    }
+
+    out << "# HELP chess_engine_http_request_duration_seconds Time from reading a request to writing its response.\n";
+    out << "# TYPE chess_engine_http_request_duration_seconds histogram\n";
+    for (int e = 0; e < ENDPOINT_COUNT; ++e) {
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b <= latency_buckets.size(); ++b) {
+            cumulative += endpoints[e].buckets[b].load(std::memory_order_relaxed);
+            out << "chess_engine_http_request_duration_seconds_bucket{endpoint=\"" << endpoint_names[e] << "\",le=\"";
+            if (b < latency_buckets.size()) {
+                out << latency_buckets[b];
+            } else {
+                out << "+Inf";
+            }
+            out << "\"} " << cumulative << "\n";
+        }
+        out << "chess_engine_http_request_duration_seconds_sum{endpoint=\"" << endpoint_names[e] << "\"} "
+            << endpoints[e].latency_sum_us.load(std::memory_order_relaxed) / 1e6 << "\n";
+        out << "chess_engine_http_request_duration_seconds_count{endpoint=\"" << endpoint_names[e] << "\"} " << cumulative << "\n";
+    }
+
+    out << "# HELP chess_engine_connections_in_flight Connections accepted and not yet answered.\n";
+    out << "# TYPE chess_engine_connections_in_flight gauge\n";
+    out << "chess_engine_connections_in_flight " << connections_in_flight.load(std::memory_order_relaxed) << "\n";
+
+    statistics::Totals totals = statistics::aggregate();
+
+    out << "# HELP chess_engine_active_searches Searches currently running.\n";
+    out << "# TYPE chess_engine_active_searches gauge\n";
+    out << "chess_engine_active_searches " << totals.active_searches << "\n";
+
+    out << "# HELP chess_engine_searches_total Searches started.\n";
+    out << "# TYPE chess_engine_searches_total counter\n";
+    out << "chess_engine_searches_total " << totals.searches << "\n";
+
+    out << "# HELP chess_engine_search_seconds_total Time spent searching, summed over all searches.\n";
+    out << "# TYPE chess_engine_search_seconds_total counter\n";
+    out << "chess_engine_search_seconds_total " << totals.search_time_us / 1e6 << "\n";
+
+    out << "# HELP chess_engine_nodes_total Nodes searched, including quiescence nodes.\n";
+    out << "# TYPE chess_engine_nodes_total counter\n";
+    out << "chess_engine_nodes_total " << totals.nodes << "\n";
+
+    out << "# HELP chess_engine_qnodes_total Nodes searched by quiescence search.\n";
+    out << "# TYPE chess_engine_qnodes_total counter\n";
+    out << "chess_engine_qnodes_total " << totals.qnodes << "\n";
+
+    out << "# HELP chess_engine_nodes_per_second Average search speed over all searches.\n";
+    out << "# TYPE chess_engine_nodes_per_second gauge\n";
+    out << "chess_engine_nodes_per_second " << static_cast<uint64_t>(ratio(totals.nodes, totals.search_time_us) * 1e6) << "\n";
+
+    out << "# HELP chess_engine_qnodes_ratio Share of nodes searched by quiescence search.\n";
+    out << "# TYPE chess_engine_qnodes_ratio gauge\n";
+    out << "chess_engine_qnodes_ratio " << ratio(totals.qnodes, totals.nodes) << "\n";
+
+    out << "# HELP chess_engine_cache_lookups_total Cache probes by cache.\n";
+    out << "# TYPE chess_engine_cache_lookups_total counter\n";
+    out << "chess_engine_cache_lookups_total{cache=\"tt\"} " << totals.tt_probes << "\n";
+
+    out << "# HELP chess_engine_cache_hits_total Cache probes that returned a usable entry, by cache.\n";
+    out << "# TYPE chess_engine_cache_hits_total counter\n";
+    out << "chess_engine_cache_hits_total{cache=\"tt\"} " << totals.tt_hits << "\n";
+
+    out << "# HELP chess_engine_cache_hit_ratio Share of cache probes that hit, by cache.\n";
+    out << "# TYPE chess_engine_cache_hit_ratio gauge\n";
+    out << "chess_engine_cache_hit_ratio{cache=\"tt\"} " << ratio(totals.tt_hits, totals.tt_probes) << "\n";
+
+    out << "# HELP chess_engine_tb_hits_total Positions resolved by a Syzygy tablebase probe.\n";
+    out << "# TYPE chess_engine_tb_hits_total counter\n";
+    out << "chess_engine_tb_hits_total " << totals.tb_hits << "\n";
+
+    out << "# HELP chess_engine_book_probes_total Opening book lookups made instead of a search.\n";
+    out << "# TYPE chess_engine_book_probes_total counter\n";
+    out << "chess_engine_book_probes_total " << totals.book_probes << "\n";
+
+    out << "# HELP chess_engine_book_hits_total Moves answered from the opening book.\n";
+    out << "# TYPE chess_engine_book_hits_total counter\n";
+    out << "chess_engine_book_hits_total " << totals.book_hits << "\n";
+
+    out << "# HELP chess_engine_tt_fill_ratio Share of the transposition table in use (sampled).\n";
+    out << "# TYPE chess_engine_tt_fill_ratio gauge\n";
+    out << "chess_engine_tt_fill_ratio " << hashfull / 1000.0 << "\n";
+
+    return out.str();
+}
+
+} // namespace metrics
+} // namespace chess_engine
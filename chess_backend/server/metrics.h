@@ -0,0 +1,30 @@
+#ifndef CHESS_ENGINE_METRICS_H
+#define CHESS_ENGINE_METRICS_H
+
+#include <string>
+
+namespace chess_engine {
+namespace metrics {
+
+enum class Endpoint {
+    MOVE,
+    STREAM,
+    METRICS,
+    SESSION,
+    OTHER,
+    COUNT
+};
+
+void connection_opened();
+void connection_closed();
+
+// Count a finished request and add its latency to the endpoint's histogram
+void record_request(Endpoint endpoint, int status, double seconds);
+
+// Render server and search counters in the Prometheus text exposition format
+std::string render(int hashfull);
+
+} // namespace metrics
+} // namespace chess_engine
+
+#endif
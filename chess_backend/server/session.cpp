@@ -0,0 +1,203 @@
+#include "session.h"
+#include "../moves/moves.h"
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+namespace chess_engine {
+namespace session {
+
+struct Entry {
+    std::shared_ptr<Session> session;
+    std::chrono::steady_clock::time_point last_used;
+};
+
+std::mutex registry_mutex;
+std::unordered_map<std::string, Entry> registry;
+size_t max_sessions = DEFAULT_MAX_SESSIONS;
+
+Session::~Session() {
+    stop_ponder();
+}
+
+bool Session::play(const std::string &uci_move) {
+    moves::Move move = moves::from_uci(uci_move, game_state);
+    if (move.is_null()) {
+        return false;
+    }
+
+    if (ponder != nullptr && !ponder->hit && move == ponder->expected) {
+        ponder->hit = true;
+    } else {
+        stop_ponder();
+    }
+
+    search_state.push_position(game_state);
+    game_state.make_move(move);
+    return true;
+}
+
+void Session::start_ponder(const moves::Move &expected) {
+    stop_ponder();
+
+    ponder = std::make_unique<Ponder>(game_state);
+    ponder->expected = expected;
+    ponder->search_state = search_state;
+    ponder->search_state.push_position(ponder->position);
+    if (!ponder->position.make_move(expected)) {
+        ponder.reset();
+        return;
+    }
+
+    search::SearchLimits limits;
+    limits.depth = search::MAX_DEPTH;
+    limits.deadline = std::chrono::steady_clock::now() + MAX_PONDER_TIME;
+
+    Ponder *state = ponder.get();
+    state->thread = std::thread([state, limits]() {
+        moves::Move best_move = search::find_best_move(limits, state->position.turn, state->position, [state](const search::SearchInfo &info) {
+            std::lock_guard<std::mutex> lock(state->progress_mutex);
+            state->last_info = info;
+        }, &state->token, &state->search_state);
+
+        std::lock_guard<std::mutex> lock(state->progress_mutex);
+        state->result = best_move;
+        state->finished = true;
+    });
+}
+
+void Session::stop_ponder() {
+    if (ponder == nullptr) {
+        return;
+    }
+    ponder->token.cancel();
+    ponder->thread.join();
+    ponder.reset();
+}
+
+moves::Move Session::search(const search::SearchLimits &limits, const search::CancellationToken &token,
+                            const search::InfoCallback &on_info) {
+    if (ponder != nullptr && ponder->hit && limits.nodes == 0) {
+        auto start = std::chrono::steady_clock::now();
+
+        // The ponder search becomes the real one, now under the request's limits: it continues
+        // until the requested time is up or it has finished the requested depth
+        std::chrono::steady_clock::time_point deadline = limits.deadline;
+        if (limits.movetime_ms > 0) {
+            deadline = std::min(deadline, start + std::chrono::milliseconds(limits.movetime_ms));
+        }
+        ponder->token.set_deadline(deadline);
+
+        while (!ponder->is_finished() && !ponder->reached(limits.depth) && !token.is_cancelled()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ponder->token.cancel();
+        ponder->thread.join();
+
+        // A stopped search returns its last completed iteration's move
+        moves::Move best_move = ponder->result.is_null() ? ponder->last_info_move() : ponder->result;
+        if (on_info && !ponder->last_info.pv.empty()) {
+            on_info(ponder->last_info);
+        }
+
+        // Keep the ordering tables the ponder search built up
+        search_state.heuristics = ponder->search_state.heuristics;
+        search_state.last_root_ply = ponder->search_state.last_root_ply;
+        ponder.reset();
+
+        if (!best_move.is_null()) {
+            return best_move;
+        }
+    }
+
+    // No hit, a node-limited search, or a ponder search stopped before any iteration: a normal
+    // search on the warm TT
+    stop_ponder();
+
+    // Search a copy so that an interrupted search cannot leave the game half-unmade
+    game_state::GameState position = game_state;
+    return search::find_best_move(limits, position.turn, position, on_info, &token, &search_state);
+}
+
+// Unguessable enough that one client cannot stumble into another's game
+std::string new_id() {
+    static std::mt19937_64 generator{std::random_device{}()};
+    std::ostringstream id;
+    id << std::hex << std::setfill('0') << std::setw(16) << generator();
+    return id.str();
+}
+
+// Drop idle sessions, then the least recently used ones while the registry is full.
+// Must be called with registry_mutex held.
+void evict(std::chrono::steady_clock::time_point now) {
+    for (auto it = registry.begin(); it != registry.end();) {
+        if (now - it->second.last_used > IDLE_TIMEOUT) {
+            it = registry.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    while (registry.size() >= max_sessions) {
+        auto oldest = registry.begin();
+        for (auto it = registry.begin(); it != registry.end(); ++it) {
+            if (it->second.last_used < oldest->second.last_used) {
+                oldest = it;
+            }
+        }
+        registry.erase(oldest);
+    }
+}
+
+std::string create(const std::string &fen) {
+    auto session = std::make_shared<Session>(game_state::set_game_state(fen));
+
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    evict(now);
+
+    std::string id;
+    do {
+        id = new_id();
+    } while (registry.count(id) != 0);
+
+    registry[id] = Entry{session, now};
+    return id;
+}
+
+std::shared_ptr<Session> find(const std::string &id) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    auto it = registry.find(id);
+    if (it == registry.end()) {
+        return nullptr;
+    }
+    if (now - it->second.last_used > IDLE_TIMEOUT) {
+        registry.erase(it);
+        return nullptr;
+    }
+
+    it->second.last_used = now;
+    return it->second.session;
+}
+
+bool remove(const std::string &id) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return registry.erase(id) != 0;
+}
+
+void set_max_sessions(size_t count) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    max_sessions = std::max<size_t>(1, count);
+}
+
+size_t count() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return registry.size();
+}
+
+} // namespace session
+} // namespace chess_engine
@@ -0,0 +1,98 @@
+#ifndef CHESS_ENGINE_SESSION_H
+#define CHESS_ENGINE_SESSION_H
+
+#include "../generator/search.h"
+#include "../structure/game_state.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace chess_engine {
+namespace session {
+
+// Sessions not used for this long are dropped
+const std::chrono::minutes IDLE_TIMEOUT{30};
+
+// Upper bound on live sessions; the least recently used one is dropped to make room
+constexpr size_t DEFAULT_MAX_SESSIONS = 256;
+
+// A ponder search is abandoned after this long even if the opponent never replies
+const std::chrono::minutes MAX_PONDER_TIME{10};
+
+// Background search of the position after the opponent's expected reply
+struct Ponder {
+    moves::Move expected;             // Opponent move being pondered on
+    bool hit = false;                 // The opponent played it; the search now serves the game
+    game_state::GameState position;   // Game after the expected move
+    search::SearchState search_state; // Copy of the session's, extended by the expected move
+    search::CancellationToken token;
+    std::thread thread;
+
+    std::mutex progress_mutex;
+    search::SearchInfo last_info; // Report of the deepest finished iteration
+    moves::Move result;           // Set when the search returns
+    bool finished = false;
+
+    explicit Ponder(const game_state::GameState &start) : position(start) {}
+
+    bool is_finished() {
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        return finished;
+    }
+
+    bool reached(int depth) {
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        return last_info.depth >= depth;
+    }
+
+    moves::Move last_info_move() {
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        return last_info.pv.empty() ? moves::Move() : last_info.pv.front();
+    }
+};
+
+// One game played through the HTTP API. Keeping it between requests lets consecutive
+// searches reuse the move-ordering tables, see repetitions and hit the warm TT.
+struct Session {
+    std::mutex mutex; // Held while the game is read, changed or searched
+    game_state::GameState game_state;
+    search::SearchState search_state;
+    std::unique_ptr<Ponder> ponder;
+
+    explicit Session(const game_state::GameState &start) : game_state(start) {}
+    ~Session();
+
+    // Play a move given in UCI notation; returns false if it is not legal here.
+    // Keeps a ponder search on this move running and aborts any other.
+    bool play(const std::string &uci_move);
+
+    // Best move for the side to move. After a ponder hit the ponder search is turned into
+    // the real one: it gets the requested time, or runs until it has finished the requested
+    // depth, which it may already have.
+    moves::Move search(const search::SearchLimits &limits, const search::CancellationToken &token,
+                       const search::InfoCallback &on_info = nullptr);
+
+    // Start searching the position after the opponent's expected reply
+    void start_ponder(const moves::Move &expected);
+    void stop_ponder();
+};
+
+// Start a game from a FEN and return its id; throws if the FEN cannot be parsed
+std::string create(const std::string &fen);
+
+// The session with this id, or nullptr if it does not exist or has expired
+std::shared_ptr<Session> find(const std::string &id);
+
+bool remove(const std::string &id);
+
+// Replace DEFAULT_MAX_SESSIONS; a smaller limit takes effect on the next create()
+void set_max_sessions(size_t count);
+
+size_t count();
+
+} // namespace session
+} // namespace chess_engine
+
+#endif
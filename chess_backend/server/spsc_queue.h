@@ -0,0 +1,55 @@
+#ifndef CHESS_ENGINE_SPSC_QUEUE_H
+#define CHESS_ENGINE_SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace chess_engine {
+namespace spsc_queue {
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// One slot is kept free to tell a full queue from an empty one.
+template <typename T, size_t Capacity>
+class SpscQueue {
+  public:
+    // Returns false without blocking when the queue is full
+    bool push(T value) {
+        size_t write = write_index.load(std::memory_order_relaxed);
+        size_t next = (write + 1) % Capacity;
+        if (next == read_index.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        buffer[write] = std::move(value);
+        write_index.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false without blocking when the queue is empty
+    bool pop(T &value) {
+        size_t read = read_index.load(std::memory_order_relaxed);
+        if (read == write_index.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        value = std::move(buffer[read]);
+        read_index.store((read + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return read_index.load(std::memory_order_acquire) == write_index.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::array<T, Capacity> buffer;
+    alignas(64) std::atomic<size_t> read_index{0};  // Next slot to read, owned by the consumer
+    alignas(64) std::atomic<size_t> write_index{0}; // Next slot to write, owned by the producer
+};
+
+} // namespace spsc_queue
+} // namespace chess_engine
+
+#endif
@@ -1,7 +1,15 @@
 #include "board.h"
 #include "../enums.h"
+#include "../moves/slide/diagonal.h"
+#include "../moves/slide/straight.h"
+#include "../pieces/king.h"
+#include "../pieces/knight.h"
+#include "../pieces/pawn.h"
 #include "bitboard.h"
+#include <array>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 
 namespace chess_engine {
 namespace board {
@@ -38,58 +46,160 @@ std::vector<int> Board::get_squares_with_piece(piece::Type type, piece::Color co
     return squares;
 }
 
+bit::Bitboard Board::attackers_to(int square, bit::Bitboard occupancy) const {
+    bit::Bitboard target = 1ULL << square;
+    bit::Bitboard diagonal = moves::diagonal::get_attacks(square, occupancy);
+    bit::Bitboard straight = moves::straight::get_attacks(square, occupancy);
+
+    // A pawn attacks the square if a pawn of the other color standing there would attack it back
+    bit::Bitboard attackers = (pawn::get_possible_attacks(piece::Color::BLACK, target) & wp) |
+                              (pawn::get_possible_attacks(piece::Color::WHITE, target) & bp);
+    attackers |= knight::knight_moves[square] & (wn | bn);
+    attackers |= king::king_moves[square] & (wk | bk);
+    attackers |= diagonal & (wb | bb | wq | bq);
+    attackers |= straight & (wr | br | wq | bq);
+    return attackers & occupancy;
+}
+
+bit::Bitboard Board::attacks_by(piece::Color color, bit::Bitboard occupancy) const {
+    bit::Bitboard attacks = pawn::get_possible_attacks(color, get_pawns(color));
+
+    bit::Bitboard knights = get_knights(color);
+    while (knights) {
+        attacks |= knight::knight_moves[__builtin_ctzll(knights)];
+        knights &= knights - 1;
+    }
+
+    bit::Bitboard diagonal_sliders = get_bishops(color) | get_queens(color);
+    while (diagonal_sliders) {
+        attacks |= moves::diagonal::get_attacks(__builtin_ctzll(diagonal_sliders), occupancy);
+        diagonal_sliders &= diagonal_sliders - 1;
+    }
+
+    bit::Bitboard straight_sliders = get_rooks(color) | get_queens(color);
+    while (straight_sliders) {
+        attacks |= moves::straight::get_attacks(__builtin_ctzll(straight_sliders), occupancy);
+        straight_sliders &= straight_sliders - 1;
+    }
+
+    bit::Bitboard king = get_king(color);
+    if (king) {
+        attacks |= king::king_moves[__builtin_ctzll(king)];
+    }
+    return attacks;
+}
+
 Board Board::copy() const {
     return Board(this->wp, this->wb, this->wn, this->wr, this->wq, this->wk,
                  this->bp, this->bb, this->bn, this->br, this->bq, this->bk);
 }
 
-Board set_position(std::string fen) {
-    bit::Bitboard wp = 0ULL, wb = 0ULL, wn = 0ULL, wr = 0ULL, wq = 0ULL, wk = 0ULL;
-    bit::Bitboard bp = 0ULL, bb = 0ULL, bn = 0ULL, br = 0ULL, bq = 0ULL, bk = 0ULL;
+// FEN letter of each piece, indexed by (color << 3) | type
+constexpr char PIECE_LETTERS[16] = {'P', 'N', 'B', 'R', 'Q', 'K', 0, 0, 'p', 'n', 'b', 'r', 'q', 'k', 0, 0};
 
-    int rank = 56;
+// (color << 3) | type of each FEN piece letter, NOT_A_PIECE for any other character
+constexpr uint8_t NOT_A_PIECE = 0xFF;
+constexpr std::array<uint8_t, 256> PIECE_CODES = [] {
+    std::array<uint8_t, 256> codes{};
+    for (auto &code : codes) {
+        code = NOT_A_PIECE;
+    }
+    for (uint8_t code = 0; code < 16; ++code) {
+        if (PIECE_LETTERS[code] != 0) {
+            codes[static_cast<unsigned char>(PIECE_LETTERS[code])] = code;
+        }
+    }
+    return codes;
+}();
+
+Board set_position(std::string_view placement) {
+    bit::Bitboard pieces[2][6] = {};
+    int rank = 7;
     int file = 0;
-    for (char c : fen) {
-
-        int square = rank + file;
-
-        if (c == 'P')
-            wp = bit::set_bit(wp, square);
-        else if (c == 'B')
-            wb = bit::set_bit(wb, square);
-        else if (c == 'N')
-            wn = bit::set_bit(wn, square);
-        else if (c == 'R')
-            wr = bit::set_bit(wr, square);
-        else if (c == 'Q')
-            wq = bit::set_bit(wq, square);
-        else if (c == 'K')
-            wk = bit::set_bit(wk, square);
-
-        else if (c == 'p')
-            bp = bit::set_bit(bp, square);
-        else if (c == 'b')
-            bb = bit::set_bit(bb, square);
-        else if (c == 'n')
-            bn = bit::set_bit(bn, square);
-        else if (c == 'r')
-            br = bit::set_bit(br, square);
-        else if (c == 'q')
-            bq = bit::set_bit(bq, square);
-        else if (c == 'k')
-            bk = bit::set_bit(bk, square);
-        else
-            file += (c - '1');
-
-        if (c == '/') {
-            rank -= 8;
+    for (char c : placement) {
+        uint8_t code = PIECE_CODES[static_cast<unsigned char>(c)];
+        if (code != NOT_A_PIECE && file < 8) {
+            pieces[code >> 3][code & 7] |= 1ULL << (rank * 8 + file);
+            ++file;
+        } else if (c >= '1' && c <= '8' && file + (c - '0') <= 8) {
+            file += c - '0';
+        } else if (c == '/' && file == 8 && rank > 0) {
+            --rank;
             file = 0;
+        } else if (c == '/' && file == 8) {
+            throw std::invalid_argument("piece placement has more than 8 ranks");
+        } else if (code != NOT_A_PIECE || (c >= '1' && c <= '8') || c == '/') {
+            throw std::invalid_argument("rank " + std::to_string(rank + 1) + " of the piece placement does not have 8 squares");
         } else {
-            ++file;
+            throw std::invalid_argument("unexpected character in rank " + std::to_string(rank + 1) + " of the piece placement");
         }
     }
+    if (rank != 0 || file != 8) {
+        throw std::invalid_argument("piece placement does not have 8 ranks of 8 squares");
+    }
+
+    for (int color = 0; color < 2; ++color) {
+        const char *side = (color == piece::Color::WHITE) ? "white" : "black";
+        if (__builtin_popcountll(pieces[color][piece::Type::KING]) != 1) {
+            throw std::invalid_argument(std::string(side) + " must have exactly one king");
+        }
+        if (pieces[color][piece::Type::PAWN] & (rank_1 | rank_8)) {
+            throw std::invalid_argument(std::string(side) + " has a pawn on the first or last rank");
+        }
+        if (__builtin_popcountll(pieces[color][piece::Type::PAWN]) > 8) {
+            throw std::invalid_argument(std::string(side) + " has more than 8 pawns");
+        }
+        bit::Bitboard all = 0ULL;
+        for (bit::Bitboard type_pieces : pieces[color]) {
+            all |= type_pieces;
+        }
+        if (__builtin_popcountll(all) > 16) {
+            throw std::invalid_argument(std::string(side) + " has more than 16 pieces");
+        }
+    }
+
+    return Board(pieces[0][piece::PAWN], pieces[0][piece::BISHOP], pieces[0][piece::KNIGHT], pieces[0][piece::ROOK],
+                 pieces[0][piece::QUEEN], pieces[0][piece::KING], pieces[1][piece::PAWN], pieces[1][piece::BISHOP],
+                 pieces[1][piece::KNIGHT], pieces[1][piece::ROOK], pieces[1][piece::QUEEN], pieces[1][piece::KING]);
+}
 
-    return Board(wp, wb, wn, wr, wq, wk, bp, bb, bn, br, bq, bk);
+std::string to_fen(const Board &board) {
+    char letters[64] = {};
+    for (int color = 0; color < 2; ++color) {
+        for (int type = piece::Type::PAWN; type <= piece::Type::KING; ++type) {
+            bit::Bitboard pieces = board.get_pieces(static_cast<piece::Type>(type), static_cast<piece::Color>(color));
+            for (; pieces != 0; pieces &= pieces - 1) {
+                letters[__builtin_ctzll(pieces)] = PIECE_LETTERS[(color << 3) | type];
+            }
+        }
+    }
+
+    // Room for the other fields too, which game_state::to_fen appends
+    std::string placement;
+    placement.reserve(96);
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            char letter = letters[rank * 8 + file];
+            if (letter == 0) {
+                ++empty;
+                continue;
+            }
+            if (empty != 0) {
+                placement += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            placement += letter;
+        }
+        if (empty != 0) {
+            placement += static_cast<char>('0' + empty);
+        }
+        if (rank != 0) {
+            placement += '/';
+        }
+    }
+    return placement;
 }
+
 } // namespace board
 } // namespace chess_engine
\ No newline at end of file
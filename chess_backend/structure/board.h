@@ -4,6 +4,7 @@
 #include "../enums.h"
 #include "bitboard.h"
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace chess_engine {
@@ -283,9 +284,23 @@ class Board {
     }
 
     std::vector<int> get_squares_with_piece(piece::Type type, piece::Color color) const;
+
+    // Pieces of both colors attacking a square, looked up from the square itself. Sliders see
+    // through squares missing from the occupancy, so pieces can be lifted or moved without
+    // changing the board.
+    bit::Bitboard attackers_to(int square, bit::Bitboard occupancy) const;
+
+    // Every square attacked by the given color, sliders blocked by the occupancy
+    bit::Bitboard attacks_by(piece::Color color, bit::Bitboard occupancy) const;
 };
 
-Board set_position(std::string fen);
+// Board of a FEN's piece placement field. Throws std::invalid_argument if the field is
+// malformed, a side does not have exactly one king, more than 8 pawns or more than 16 pieces,
+// or a pawn stands on the first or last rank.
+Board set_position(std::string_view placement);
+
+// Piece placement field of a FEN
+std::string to_fen(const Board &board);
 
 } // namespace board
 } // namespace chess_engine
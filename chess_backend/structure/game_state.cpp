@@ -2,10 +2,12 @@
 #include "../enums.h"
 #include "../moves/moves.h"
 #include "../pieces/king.h"
+#include <algorithm>
+#include <charconv>
 #include <chrono>
 #include <iostream>
 #include <limits>
-#include <sstream>
+#include <stdexcept>
 #include <thread>
 
 namespace chess_engine {
@@ -19,13 +21,11 @@ GameState::GameState(const board::Board &board, piece::Color turn, bool w_k_cast
       halfmove_clock(halfmove), fullmove_number(fullmove) {}
 
 const bool GameState::is_in_check(piece::Color color) const {
-    bit::Bitboard opposite_team_attacks = moves::get_all_piece_moves(utils::opposite_color(color), board, *this);
-    bit::Bitboard current_king_position = board.get_king(color);
-
-    if (current_king_position & opposite_team_attacks) {
-        return true;
+    bit::Bitboard king = board.get_king(color);
+    if (!king) {
+        return false;
     }
-    return false;
+    return is_square_attacked(__builtin_ctzll(king), color);
 }
 
 bool GameState::is_checkmate() {
@@ -79,57 +79,50 @@ bool GameState::is_game_over() {
     return false;
 }
 
+// Whether the pieces of the color opposite to the given one attack the square
 bool GameState::is_square_attacked(int sq, piece::Color color) const {
-    bit::Bitboard attacked_squares = 0ULL;
-
-    // Generate moves for all pieces except the king                                                exclude king
-    attacked_squares |= moves::get_all_piece_moves(utils::opposite_color(color), board, *this, true);
+    bit::Bitboard enemies = (color == piece::Color::WHITE) ? board.get_black_pieces() : board.get_white_pieces();
+    return (board.attackers_to(sq, board.get_occupied_squares()) & enemies) != 0;
+}
 
-    // Check if the opponent's king attacks the square manually
-    bit::Bitboard opponent_king = board.get_king(utils::opposite_color(color));
-    int king_square = __builtin_ffsll(opponent_king) - 1;
-    bit::Bitboard king_moves = king::king_moves[king_square];
-    attacked_squares |= king_moves;
+bit::Bitboard GameState::attack_map(piece::Color color) const {
+    size_t ply = move_history.size();
+    if (attack_cache.size() <= ply) {
+        attack_cache.resize(ply + 1);
+    }
 
-    return (((1ULL << sq) & attacked_squares) != 0);
+    AttackMaps &entry = attack_cache[ply];
+    if (!entry.valid[color]) {
+        bit::Bitboard occupancy = board.get_occupied_squares() & ~board.get_king(utils::opposite_color(color));
+        entry.maps[color] = board.attacks_by(color, occupancy);
+        entry.valid[color] = true;
+    }
+    return entry.maps[color];
 }
 
 void GameState::switch_turn() {
     turn = (turn == piece::WHITE) ? piece::BLACK : piece::WHITE;
 }
 
+// Called once the move is on the board, so the moved piece stands on the to square
 void GameState::update_castling_rights(int from, int to) {
     // If the king moves, lose castling rights
-    if (board.get_piece_type(from, turn) == piece::KING) {
+    if (board.get_piece_type(to, turn) == piece::KING) {
         if (turn == piece::WHITE) {
             white_castle_kingside = white_castle_queenside = false;
         } else {
             black_castle_kingside = black_castle_queenside = false;
         }
     }
-    // If a rook moves, update castling rights accordingly
-    if (board.get_piece_type(from, turn) == piece::ROOK) {
-        if (turn == piece::WHITE) {
-            if (from == square::H1)
-                white_castle_kingside = false;
-            if (from == square::A1)
-                white_castle_queenside = false;
-        } else {
-            if (from == square::H8)
-                black_castle_kingside = false;
-            if (from == square::A8)
-                black_castle_queenside = false;
-        }
-    }
-    // If a rook is captured, update castling rights
-    if (board.get_piece_type(to, utils::opposite_color(turn)) == piece::Type::ROOK) {
-        if (to == square::H1)
+    // A move from or to a rook's corner means the rook moved or was captured
+    for (int sq : {from, to}) {
+        if (sq == square::H1)
             white_castle_kingside = false;
-        if (to == square::A1)
+        if (sq == square::A1)
             white_castle_queenside = false;
-        if (to == square::H8)
+        if (sq == square::H8)
             black_castle_kingside = false;
-        if (to == square::A8)
+        if (sq == square::A8)
             black_castle_queenside = false;
     }
 }
@@ -137,7 +130,7 @@ void GameState::update_castling_rights(int from, int to) {
 void GameState::update_en_passant(int from, int to) {
     en_passant_square = -1; // Reset en passant by default
     // If a pawn moves two squares, set up en passant square
-    if (board.get_piece_type(from, turn) == piece::PAWN) {
+    if (board.get_piece_type(to, turn) == piece::PAWN) {
         if (abs(from - to) == 16) {
             en_passant_square = (from + to) / 2;
         }
@@ -220,6 +213,15 @@ bool GameState::make_move(moves::Move move) {
     rev_move.black_castle_queenside = black_castle_queenside;
     rev_move.en_passant_square = en_passant_square;
     rev_move.halfmove_clock = halfmove_clock;
+    rev_move.fullmove_number = fullmove_number;
+
+    // The position after this move gets a fresh attack map entry and accumulator
+    if (attack_cache.size() > move_history.size() + 1) {
+        attack_cache[move_history.size() + 1] = AttackMaps();
+    }
+    if (accumulators.size() > move_history.size() + 1) {
+        accumulators[move_history.size() + 1].network = 0;
+    }
 
     // Get the bitboard for the moving piece
     bit::Bitboard &piece_bitboard = board.get_pieces(piece_type, turn);
@@ -347,7 +349,10 @@ bool GameState::make_move(moves::Move move) {
         ++halfmove_clock;
     }
 
-    ++fullmove_number;
+    // A full move ends with Black's reply
+    if (color == piece::Color::BLACK) {
+        ++fullmove_number;
+    }
 
     // Update castling rights and en passant
     update_castling_rights(from, to);
@@ -398,6 +403,12 @@ bool GameState::unmake_move() {
         board.add_piece(rev_move.move.to, rev_move.captured_piece, utils::opposite_color(rev_move.move.color));
     }
 
+    // En passant took the pawn beside the target square
+    if (rev_move.move.move_type == moves::EN_PASSANT) {
+        int captured_pawn_square = (rev_move.move.color == piece::Color::WHITE) ? rev_move.move.to - 8 : rev_move.move.to + 8;
+        board.add_piece(captured_pawn_square, piece::PAWN, utils::opposite_color(rev_move.move.color));
+    }
+
     // Restore castling rights, en passant square, halfmove clock, etc.
     turn = rev_move.turn;
     white_castle_kingside = rev_move.white_castle_kingside;
@@ -411,36 +422,131 @@ bool GameState::unmake_move() {
     return true;
 }
 
-GameState set_game_state(const std::string &fen) {
-    std::istringstream fen_stream(fen);
-    std::string piece_placement, active_color_str, castling_rights, en_passant_target;
-    int halfmove_clock, fullmove_number;
+// Fields of a FEN, separated by runs of spaces
+int split_fields(std::string_view fen, std::string_view (&fields)[6]) {
+    int count = 0;
+    size_t position = 0;
+    while (true) {
+        position = fen.find_first_not_of(' ', position);
+        if (position == std::string_view::npos) {
+            return count;
+        }
+        if (count == 6) {
+            throw std::invalid_argument("unexpected text after the move counters");
+        }
+        size_t end = std::min(fen.find(' ', position), fen.size());
+        fields[count++] = fen.substr(position, end - position);
+        position = end;
+    }
+}
+
+int parse_counter(std::string_view field, const char *name, int minimum) {
+    int value = 0;
+    auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (error != std::errc() || end != field.data() + field.size() || value < minimum) {
+        throw std::invalid_argument(std::string(name) + " must be a number of at least " + std::to_string(minimum));
+    }
+    return value;
+}
 
-    // Parse FEN string
-    fen_stream >> piece_placement >> active_color_str >> castling_rights >> en_passant_target >> halfmove_clock >> fullmove_number;
+GameState set_game_state(std::string_view fen) {
+    std::string_view fields[6];
+    int field_count = split_fields(fen, fields);
+    if (field_count < 4) {
+        throw std::invalid_argument("expected at least 4 fields");
+    }
 
     // Set up the board
-    board::Board board = board::set_position(piece_placement);
+    board::Board board = board::set_position(fields[0]);
 
     // Determine active color
-    piece::Color turn = (active_color_str == "w") ? piece::WHITE : piece::BLACK;
+    if (fields[1] != "w" && fields[1] != "b") {
+        throw std::invalid_argument("side to move must be w or b");
+    }
+    piece::Color turn = (fields[1] == "w") ? piece::WHITE : piece::BLACK;
+
+    // Parse castling rights; each needs its king and rook on their starting squares
+    constexpr std::string_view CASTLING_LETTERS = "KQkq";
+    constexpr int KING_SQUARES[4] = {square::E1, square::E1, square::E8, square::E8};
+    constexpr int ROOK_SQUARES[4] = {square::H1, square::A1, square::H8, square::A8};
+    bool castling[4] = {false, false, false, false};
+    if (fields[2] != "-") {
+        for (char c : fields[2]) {
+            size_t right = CASTLING_LETTERS.find(c);
+            if (right == std::string_view::npos || castling[right]) {
+                throw std::invalid_argument("castling rights must be - or a subset of KQkq");
+            }
+            castling[right] = true;
 
-    // Parse castling rights
-    bool white_castle_kingside = castling_rights.find('K') != std::string::npos;
-    bool white_castle_queenside = castling_rights.find('Q') != std::string::npos;
-    bool black_castle_kingside = castling_rights.find('k') != std::string::npos;
-    bool black_castle_queenside = castling_rights.find('q') != std::string::npos;
+            piece::Color color = (right < 2) ? piece::WHITE : piece::BLACK;
+            if (!(board.get_king(color) & (1ULL << KING_SQUARES[right])) ||
+                !(board.get_rooks(color) & (1ULL << ROOK_SQUARES[right]))) {
+                throw std::invalid_argument(std::string("castling right ") + c + " without the king and rook on their starting squares");
+            }
+        }
+    }
 
-    // Parse en passant target square
+    // Parse en passant target square: behind a pawn that just moved two squares
     int en_passant_square = -1; // Default is no en passant available
-    if (en_passant_target != "-") {
-        en_passant_square = square::string_to_square(en_passant_target);
+    if (fields[3] != "-") {
+        bool on_board = fields[3].size() == 2 && fields[3][0] >= 'a' && fields[3][0] <= 'h' && fields[3][1] >= '1' && fields[3][1] <= '8';
+        int target = on_board ? (fields[3][1] - '1') * 8 + (fields[3][0] - 'a') : -1;
+        int pushed = (turn == piece::WHITE) ? target - 8 : target + 8;
+        int origin = (turn == piece::WHITE) ? target + 8 : target - 8;
+        bit::Bitboard occupied = board.get_white_pieces() | board.get_black_pieces();
+        if (!on_board || target / 8 != ((turn == piece::WHITE) ? 5 : 2) ||
+            !(board.get_pawns(utils::opposite_color(turn)) & (1ULL << pushed)) || (occupied & ((1ULL << target) | (1ULL << origin)))) {
+            throw std::invalid_argument("en passant square must be - or the square behind a pawn that just moved two squares");
+        }
+        en_passant_square = target;
+    }
+
+    // The move counters may be left out, as in EPD
+    int halfmove_clock = (field_count > 4) ? parse_counter(fields[4], "halfmove clock", 0) : 0;
+    int fullmove_number = (field_count > 5) ? parse_counter(fields[5], "fullmove number", 1) : 1;
+
+    GameState state(board, turn, castling[0], castling[1], castling[2], castling[3], en_passant_square,
+                    halfmove_clock, fullmove_number);
+    if (state.is_in_check(utils::opposite_color(turn))) {
+        throw std::invalid_argument("the side not to move is in check");
+    }
+    return state;
+}
+
+std::string to_fen(const GameState &state) {
+    std::string fen = board::to_fen(state.board);
+    fen += (state.turn == piece::WHITE) ? " w " : " b ";
+
+    size_t castling_start = fen.size();
+    if (state.white_castle_kingside) {
+        fen += 'K';
+    }
+    if (state.white_castle_queenside) {
+        fen += 'Q';
+    }
+    if (state.black_castle_kingside) {
+        fen += 'k';
+    }
+    if (state.black_castle_queenside) {
+        fen += 'q';
+    }
+    if (fen.size() == castling_start) {
+        fen += '-';
+    }
+
+    fen += ' ';
+    if (state.en_passant_square < 0) {
+        fen += '-';
+    } else {
+        fen += static_cast<char>('a' + state.en_passant_square % 8);
+        fen += static_cast<char>('1' + state.en_passant_square / 8);
     }
 
-    // Create and return the GameState object
-    return GameState(board, turn, white_castle_kingside, white_castle_queenside,
-                     black_castle_kingside, black_castle_queenside, en_passant_square,
-                     halfmove_clock, fullmove_number);
+    fen += ' ';
+    fen += std::to_string(state.halfmove_clock);
+    fen += ' ';
+    fen += std::to_string(state.fullmove_number);
+    return fen;
 }
 
 } // namespace game_state
@@ -2,6 +2,7 @@
 #define CHESS_ENGINE_GAME_STATE_H
 
 #include "../enums.h"
+#include "../generator/nnue.h"
 #include "../moves/moves.h"
 #include "../utils.h"
 #include "bitboard.h"
@@ -9,6 +10,8 @@
 #include <deque>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace chess_engine {
 namespace game_state {
@@ -40,6 +43,10 @@ class GameState {
     // Stack to store previous game states (useful for unmaking moves)
     std::deque<moves::Reversible_Move> move_history;
 
+    // NNUE accumulators, indexed by the size of move_history like the attack maps. make_move
+    // marks the child's entry stale and nnue::evaluate brings it up to date from its parent.
+    mutable std::vector<nnue::Accumulator> accumulators;
+
     GameState() = default; // Default constructor
 
     GameState(const board::Board &board, piece::Color turn, bool w_k_castle, bool w_q_castle,
@@ -57,6 +64,11 @@ class GameState {
     const bool is_in_check(piece::Color color) const;
     GameState copy() const;
 
+    // Squares attacked by the given color with the other king lifted off the board, so that a
+    // slider giving check also covers the squares behind the king: that king may move to none
+    // of them. Computed on first use and cached for the current ply.
+    bit::Bitboard attack_map(piece::Color color) const;
+
     bool make_move(moves::Move move);
     bool make_pseudo_move(moves::Move move);
     bool unmake_move();
@@ -70,10 +82,26 @@ class GameState {
     board::Board &get_board() {
         return board;
     }
+
+  private:
+    struct AttackMaps {
+        bool valid[2] = {false, false};
+        bit::Bitboard maps[2] = {0ULL, 0ULL};
+    };
+
+    // One entry per ply, indexed by the size of move_history; unmaking a move returns to
+    // the parent's entry, which is still valid
+    mutable std::vector<AttackMaps> attack_cache;
 };
 
-// Function declarations
-GameState set_game_state(const std::string &fen);
+// Position of a FEN; the move counters may be left out ("0 1"). Throws std::invalid_argument
+// naming the first problem: a malformed field, a board set_position rejects, castling rights
+// without the king and rook at home, an en passant square not behind a pawn that just moved
+// two squares, or the side not to move in check.
+GameState set_game_state(std::string_view fen);
+
+// FEN of the position; set_game_state(to_fen(state)) reproduces it
+std::string to_fen(const GameState &state);
 
 } // namespace game_state
 } // namespace chess_engine
@@ -0,0 +1,92 @@
+#include "../bookgen/bookgen.h"
+#include "../generator/book.h"
+#include "../generator/zobrist.h"
+#include "../structure/game_state.h"
+#include "../utils.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace chess_engine;
+
+// Checks the engine's Polyglot keys against the hashes published with the format, and that a
+// book written by bookgen is found at those keys, so that the books it reads and writes are
+// interchangeable with those of other Polyglot tools.
+
+struct KeyCase {
+    std::string moves; // UCI moves from the initial position
+    uint64_t key;
+};
+
+const KeyCase PUBLISHED_KEYS[] = {
+    {"", zobrist::POLYGLOT_START_KEY},
+    {"e2e4", 0x823C9B50FD114196ULL},
+    {"e2e4 d7d5", 0x0756B94461C50FB0ULL},
+    {"e2e4 d7d5 e4e5", 0x662FAFB965DB29D4ULL},
+    {"e2e4 d7d5 e4e5 f7f5", 0x22A48B5A8E47FF78ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2", 0x652A607CA3F242C1ULL},
+    {"e2e4 d7d5 e4e5 f7f5 e1e2 e8f7", 0x00FDD303C946BDD9ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4", 0x3C8123EA7B067637ULL},
+    {"a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5C3F9B829B279560ULL},
+};
+
+game_state::GameState play(const std::string &moves) {
+    game_state::GameState state = game_state::set_game_state(utils::START_FEN);
+    std::istringstream words(moves);
+    std::string word;
+    while (words >> word) {
+        state.make_move(moves::from_uci(word, state));
+    }
+    return state;
+}
+
+// Three games: 1. e4 is played twice and scores 1.5/2, 1. d4 loses and is left out
+const char *BOOK_PGN = "[Event \"?\"]\n[Result \"1-0\"]\n\n1. e4 e5 1-0\n\n"
+                       "[Event \"?\"]\n[Result \"1/2-1/2\"]\n\n1. e4 c5 1/2-1/2\n\n"
+                       "[Event \"?\"]\n[Result \"0-1\"]\n\n1. d4 d5 0-1\n";
+
+// Polyglot encoding of e2e4: from square 12, to square 28
+constexpr uint16_t E2E4 = (12 << 6) | 28;
+
+int check_book_round_trip() {
+    const std::string pgn_path = "polyglot_test.pgn";
+    const std::string book_path = "polyglot_test.bin";
+    std::ofstream(pgn_path) << BOOK_PGN;
+
+    bookgen::Progress progress;
+    bookgen::write_book(book_path, bookgen::build({pgn_path}, bookgen::Options(), progress));
+
+    int failures = 0;
+    if (!book::open(book_path)) {
+        std::fprintf(stderr, "cannot open the book written to %s\n", book_path.c_str());
+        ++failures;
+    } else {
+        std::vector<book::Entry> entries = book::lookup(zobrist::POLYGLOT_START_KEY);
+        if (entries.size() != 1 || entries[0].move != E2E4 || entries[0].weight == 0) {
+            std::fprintf(stderr, "book entries at the initial position's key: %zu, expected e2e4 alone\n", entries.size());
+            ++failures;
+        }
+        book::close();
+    }
+
+    std::remove(pgn_path.c_str());
+    std::remove(book_path.c_str());
+    return failures;
+}
+
+int main() {
+    zobrist::init_zobrist_keys();
+
+    int failures = check_book_round_trip();
+    for (const auto &test : PUBLISHED_KEYS) {
+        uint64_t key = zobrist::polyglot_hash(play(test.moves));
+        if (key != test.key) {
+            std::fprintf(stderr, "polyglot_hash after \"%s\": %016llx, expected %016llx\n", test.moves.c_str(),
+                         static_cast<unsigned long long>(key), static_cast<unsigned long long>(test.key));
+            ++failures;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
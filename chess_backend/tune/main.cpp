@@ -0,0 +1,106 @@
+#include "tune.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chess_engine;
+
+// Texel tuning of the hand-written evaluation: fits its weights to the results of labeled quiet
+// positions and writes them out as a new eval_weights.h.
+//
+// Usage: chess_tune [options] <positions.epd | records.bin>...
+//   --out <file>            Header to write (default eval_weights.h)
+//   --epochs <n>            Gradient descent steps over the whole set (default 500)
+//   --lr <x>                Adam step size in centipawns (default 1)
+//   --k <x>                 Sigmoid scale; fitted to the current weights when not given
+//   --max-positions <n>     Use only the first n positions
+//   --threads <n>           Worker threads (default: one per hardware thread)
+//   --report <n>            Print every n epochs (default 10)
+
+int main(int argc, char **argv) {
+    tune::Options options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string out_path = "eval_weights.h";
+    std::vector<std::string> paths;
+    size_t max_positions = 0;
+    double k = 0;
+    int report_every = 10;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) != 0) {
+                paths.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            std::string value = argv[++i];
+
+            if (arg == "--out") {
+                out_path = value;
+            } else if (arg == "--epochs") {
+                options.epochs = std::max(0, std::stoi(value));
+            } else if (arg == "--lr") {
+                options.learning_rate = std::stod(value);
+            } else if (arg == "--k") {
+                k = std::stod(value);
+            } else if (arg == "--max-positions") {
+                max_positions = std::stoull(value);
+            } else if (arg == "--threads") {
+                options.threads = std::max(1, std::stoi(value));
+            } else if (arg == "--report") {
+                report_every = std::max(1, std::stoi(value));
+            } else {
+                throw std::invalid_argument("unknown argument: " + arg);
+            }
+        }
+        if (paths.empty()) {
+            throw std::invalid_argument("no position files given");
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        tune::Dataset data = tune::load(paths, options.threads, max_positions);
+        std::chrono::duration<double> load_time = std::chrono::steady_clock::now() - start;
+        if (data.positions.empty()) {
+            throw std::invalid_argument("no labeled positions read");
+        }
+        std::printf("%zu positions (%llu lines skipped) loaded in %.1f s, %.1f MB in memory\n", data.positions.size(),
+                    static_cast<unsigned long long>(data.skipped), load_time.count(),
+                    (data.positions.size() * sizeof(tune::Position) + data.pieces.size() * sizeof(uint16_t)) / double(1 << 20));
+
+        std::vector<double> weights = tune::current_weights();
+        if (k <= 0) {
+            k = tune::find_k(data, weights, options.threads);
+        }
+        std::printf("k = %.4f, initial loss %.6f\n", k, tune::loss(data, weights, k, options.threads));
+        std::fflush(stdout);
+
+        tune::optimize(data, weights, k, options, [&](const tune::EpochReport &report) {
+            if (report.epoch % report_every == 0 || report.epoch == options.epochs) {
+                std::printf("epoch %d: loss %.6f, %.2fM positions/s\n", report.epoch, report.loss, report.positions_per_second / 1e6);
+                std::fflush(stdout);
+            }
+        });
+        std::printf("final loss %.6f\n", tune::loss(data, weights, k, options.threads));
+
+        std::ofstream out(out_path);
+        out << tune::weights_header(weights);
+        if (!out) {
+            throw std::runtime_error("cannot write " + out_path);
+        }
+        std::printf("weights written to %s\n", out_path.c_str());
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "chess_tune: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,466 @@
+#include "tune.h"
+#include "../datagen/datagen.h"
+#include "../enums.h"
+#include "../generator/eval_weights.h"
+#include "../generator/evaluate.h"
+#include "../structure/board.h"
+#include "../utils.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace chess_engine {
+namespace tune {
+
+// Positions whose evaluations, errors and gradient coefficients are computed together, so
+// that the arrays stay in L1 and the loss loop runs over contiguous values
+constexpr size_t BLOCK = 1024;
+
+const char *const PIECE_NAMES[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+
+// White's result in half points, or -1 if the line has no label
+int parse_result(const char *p, const char *end) {
+    std::string text(p, end);
+    if (text.find("1/2-1/2") != std::string::npos) {
+        return 1;
+    }
+    if (text.find("1-0") != std::string::npos) {
+        return 2;
+    }
+    if (text.find("0-1") != std::string::npos) {
+        return 0;
+    }
+
+    // A score, bracketed or as the last field
+    size_t start = text.find('[');
+    if (start == std::string::npos) {
+        start = text.find_last_of(" \t");
+    }
+    if (start == std::string::npos) {
+        return -1;
+    }
+    char *parsed = nullptr;
+    double score = std::strtod(text.c_str() + start + 1, &parsed);
+    if (parsed == text.c_str() + start + 1) {
+        return -1;
+    }
+    if (score == 1.0 || score == 0.5 || score == 0.0) {
+        return static_cast<int>(score * 2);
+    }
+    return -1;
+}
+
+// Append a position with White's result in half points
+void add_position(const board::Board &board, int result, Dataset &data) {
+    evaluate::PawnKingTerms terms = evaluate::pawn_king_terms(board);
+
+    Position position;
+    position.first = static_cast<uint32_t>(data.pieces.size());
+    position.phase = static_cast<uint8_t>(evaluate::game_phase(board));
+    position.result = static_cast<uint8_t>(result);
+    position.doubled_files = static_cast<int8_t>(terms.doubled_files);
+    position.isolated_files = static_cast<int8_t>(terms.isolated_files);
+    position.shield_pawns = static_cast<int8_t>(terms.shield_pawns);
+    for (int color = 0; color < 2; ++color) {
+        for (int type = 0; type < 6; ++type) {
+            bit::Bitboard b = board.get_pieces(static_cast<piece::Type>(type), static_cast<piece::Color>(color));
+            for (; b != 0; b &= b - 1) {
+                data.pieces.push_back(static_cast<uint16_t>((color << 9) | (type << 6) | __builtin_ctzll(b)));
+            }
+        }
+    }
+    position.count = static_cast<uint8_t>(data.pieces.size() - position.first);
+    data.positions.push_back(position);
+}
+
+// Append the position of one line; false if it cannot be read
+bool parse_line(const char *line, const char *end, Dataset &data) {
+    // Piece placement, from a8 to h1
+    bit::Bitboard pieces[2][6] = {};
+    int rank = 7, file = 0;
+    const char *p = line;
+    for (; p < end && *p != ' '; ++p) {
+        char c = *p;
+        if (c == '/') {
+            --rank;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            const char *types = "pnbrqk";
+            const char *found = std::strchr(types, std::tolower(c));
+            if (found == nullptr || rank < 0 || file > 7) {
+                return false;
+            }
+            int color = std::islower(c) ? 1 : 0;
+            pieces[color][found - types] |= 1ULL << (rank * 8 + file);
+            ++file;
+        }
+    }
+    if (rank != 0 || p == end) {
+        return false;
+    }
+
+    int result = parse_result(p, end);
+    if (result < 0) {
+        return false;
+    }
+
+    add_position(board::Board(pieces[0][piece::PAWN], pieces[0][piece::BISHOP], pieces[0][piece::KNIGHT],
+                              pieces[0][piece::ROOK], pieces[0][piece::QUEEN], pieces[0][piece::KING],
+                              pieces[1][piece::PAWN], pieces[1][piece::BISHOP], pieces[1][piece::KNIGHT],
+                              pieces[1][piece::ROOK], pieces[1][piece::QUEEN], pieces[1][piece::KING]),
+                 result, data);
+    return true;
+}
+
+// Binary self-play records (datagen) rather than text
+bool is_shard(const std::string &path) {
+    return path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+}
+
+// Start of the first line at or after offset
+size_t line_start(const utils::MappedFile &file, size_t offset) {
+    if (offset == 0 || offset >= file.size()) {
+        return std::min(offset, file.size());
+    }
+    const void *newline = std::memchr(file.data() + offset - 1, '\n', file.size() - offset + 1);
+    return (newline == nullptr) ? file.size() : static_cast<const char *>(newline) - file.data() + 1;
+}
+
+Dataset load(const std::vector<std::string> &paths, int threads, size_t max_positions) {
+    threads = std::max(1, threads);
+    Dataset data;
+
+    for (const auto &path : paths) {
+        std::vector<Dataset> parts(threads);
+        auto run = [&](const std::function<void(int)> &part) {
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back(part, t);
+            }
+            for (auto &worker : workers) {
+                worker.join();
+            }
+        };
+
+        if (is_shard(path)) {
+            datagen::Shard shard(path);
+            run([&](int t) {
+                size_t end = (t + 1 == threads) ? shard.size() : shard.size() / threads * (t + 1);
+                for (size_t i = shard.size() / threads * t; i < end; ++i) {
+                    if (shard[i].result > 2) {
+                        ++parts[t].skipped;
+                        continue;
+                    }
+                    add_position(datagen::unpack_board(shard[i]), shard[i].result, parts[t]);
+                }
+            });
+        } else {
+            utils::MappedFile file(path);
+            run([&](int t) {
+                size_t begin = line_start(file, file.size() / threads * t);
+                size_t end = (t + 1 == threads) ? file.size() : line_start(file, file.size() / threads * (t + 1));
+                const char *p = file.data() + begin;
+                const char *stop = file.data() + end;
+                while (p < stop) {
+                    const char *newline = static_cast<const char *>(std::memchr(p, '\n', stop - p));
+                    const char *line_end = (newline == nullptr) ? stop : newline;
+                    if (line_end > p && !parse_line(p, line_end, parts[t])) {
+                        ++parts[t].skipped;
+                    }
+                    p = line_end + 1;
+                }
+            });
+        }
+
+        for (auto &part : parts) {
+            uint32_t offset = static_cast<uint32_t>(data.pieces.size());
+            for (auto position : part.positions) {
+                position.first += offset;
+                data.positions.push_back(position);
+            }
+            data.pieces.insert(data.pieces.end(), part.pieces.begin(), part.pieces.end());
+            data.skipped += part.skipped;
+        }
+        if (max_positions != 0 && data.positions.size() >= max_positions) {
+            break;
+        }
+    }
+
+    if (max_positions != 0 && data.positions.size() > max_positions) {
+        data.positions.resize(max_positions);
+        data.pieces.resize(data.positions.back().first + data.positions.back().count);
+    }
+    return data;
+}
+
+std::vector<double> current_weights() {
+    std::vector<double> weights(WEIGHT_COUNT, 0.0);
+    for (int type = 0; type < 5; ++type) {
+        weights[MATERIAL + type] = evaluate::material_value[type];
+        weights[MG_VALUE + type] = evaluate::mg_value[type];
+        weights[EG_VALUE + type] = evaluate::eg_value[type];
+    }
+    for (int type = 0; type < 6; ++type) {
+        for (int sq = 0; sq < 64; ++sq) {
+            weights[MG_TABLE + 64 * type + sq] = evaluate::mg_pesto_table[type][sq];
+            weights[EG_TABLE + 64 * type + sq] = evaluate::eg_pesto_table[type][sq];
+        }
+    }
+    weights[DOUBLED] = evaluate::doubled_pawn_penalty;
+    weights[ISOLATED] = evaluate::isolated_pawn_penalty;
+    weights[SHIELD] = evaluate::king_shield_bonus;
+    return weights;
+}
+
+// The linear evaluation of a position, from White's side
+inline double evaluate_position(const Dataset &data, const Position &position, const double *weights) {
+    double material = 0, mg = 0, eg = 0;
+    const uint16_t *piece = &data.pieces[position.first];
+    for (int i = 0; i < position.count; ++i) {
+        int black = piece[i] >> 9;
+        int type = (piece[i] >> 6) & 7;
+        int sq = (piece[i] & 63) ^ (black ? 56 : 0);
+        double sign = black ? -1.0 : 1.0;
+        if (type < piece::KING) {
+            material += sign * weights[MATERIAL + type];
+            mg += sign * weights[MG_VALUE + type];
+            eg += sign * weights[EG_VALUE + type];
+        }
+        mg += sign * weights[MG_TABLE + 64 * type + sq];
+        eg += sign * weights[EG_TABLE + 64 * type + sq];
+    }
+    double phase = position.phase;
+    return material + (mg * phase + eg * (evaluate::MAX_PHASE - phase)) / evaluate::MAX_PHASE -
+           weights[DOUBLED] * position.doubled_files - weights[ISOLATED] * position.isolated_files +
+           weights[SHIELD] * position.shield_pawns;
+}
+
+// Add coefficient times the derivative of the evaluation by each weight to gradient
+inline void add_gradient(const Dataset &data, const Position &position, double coefficient, double *gradient) {
+    double phase = position.phase;
+    double mg_share = coefficient * phase / evaluate::MAX_PHASE;
+    double eg_share = coefficient - mg_share;
+    const uint16_t *piece = &data.pieces[position.first];
+    for (int i = 0; i < position.count; ++i) {
+        int black = piece[i] >> 9;
+        int type = (piece[i] >> 6) & 7;
+        int sq = (piece[i] & 63) ^ (black ? 56 : 0);
+        double sign = black ? -1.0 : 1.0;
+        if (type < piece::KING) {
+            gradient[MATERIAL + type] += sign * coefficient;
+            gradient[MG_VALUE + type] += sign * mg_share;
+            gradient[EG_VALUE + type] += sign * eg_share;
+        }
+        gradient[MG_TABLE + 64 * type + sq] += sign * mg_share;
+        gradient[EG_TABLE + 64 * type + sq] += sign * eg_share;
+    }
+    gradient[DOUBLED] -= coefficient * position.doubled_files;
+    gradient[ISOLATED] -= coefficient * position.isolated_files;
+    gradient[SHIELD] += coefficient * position.shield_pawns;
+}
+
+// Sum of squared errors over a range of positions and, if gradient is given, the gradient of
+// that sum by each weight
+double error_sum(const Dataset &data, size_t begin, size_t end, const double *weights, double k, double *gradient) {
+    // Win probability 1 / (1 + 10^(-k * eval / 400)) = 1 / (1 + e^(-scale * eval))
+    const double scale = k * std::log(10.0) / 400.0;
+    double evals[BLOCK], coefficients[BLOCK], results[BLOCK];
+    double sum = 0;
+
+    for (size_t block = begin; block < end; block += BLOCK) {
+        size_t count = std::min(BLOCK, end - block);
+        for (size_t i = 0; i < count; ++i) {
+            const Position &position = data.positions[block + i];
+            evals[i] = evaluate_position(data, position, weights);
+            results[i] = position.result * 0.5;
+        }
+
+        // Dense and branch-free, so that it vectorizes
+        for (size_t i = 0; i < count; ++i) {
+            double probability = 1.0 / (1.0 + std::exp(-scale * evals[i]));
+            double error = probability - results[i];
+            sum += error * error;
+            coefficients[i] = 2.0 * error * probability * (1.0 - probability) * scale;
+        }
+
+        if (gradient != nullptr) {
+            for (size_t i = 0; i < count; ++i) {
+                add_gradient(data, data.positions[block + i], coefficients[i], gradient);
+            }
+        }
+    }
+    return sum;
+}
+
+// Mean squared error and, if gradient is given, its gradient, over all positions on all threads
+double mean_error(const Dataset &data, const std::vector<double> &weights, double k, int threads, std::vector<double> *gradient) {
+    threads = std::max(1, threads);
+    size_t total = data.positions.size();
+    if (total == 0) {
+        return 0;
+    }
+
+    std::vector<double> sums(threads, 0.0);
+    std::vector<std::vector<double>> gradients(gradient != nullptr ? threads : 0, std::vector<double>(WEIGHT_COUNT, 0.0));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            size_t begin = total * t / threads;
+            size_t end = total * (t + 1) / threads;
+            sums[t] = error_sum(data, begin, end, weights.data(), k, gradient != nullptr ? gradients[t].data() : nullptr);
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    double sum = 0;
+    for (double part : sums) {
+        sum += part;
+    }
+    if (gradient != nullptr) {
+        gradient->assign(WEIGHT_COUNT, 0.0);
+        for (const auto &part : gradients) {
+            for (int i = 0; i < WEIGHT_COUNT; ++i) {
+                (*gradient)[i] += part[i] / total;
+            }
+        }
+    }
+    return sum / total;
+}
+
+double loss(const Dataset &data, const std::vector<double> &weights, double k, int threads) {
+    return mean_error(data, weights, k, threads, nullptr);
+}
+
+double find_k(const Dataset &data, const std::vector<double> &weights, int threads) {
+    // Golden-section search; the loss is unimodal in k
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    double low = 0.05, high = 4.0;
+    double a = high - ratio * (high - low), b = low + ratio * (high - low);
+    double loss_a = loss(data, weights, a, threads), loss_b = loss(data, weights, b, threads);
+    for (int i = 0; i < 40; ++i) {
+        if (loss_a < loss_b) {
+            high = b;
+            b = a;
+            loss_b = loss_a;
+            a = high - ratio * (high - low);
+            loss_a = loss(data, weights, a, threads);
+        } else {
+            low = a;
+            a = b;
+            loss_a = loss_b;
+            b = low + ratio * (high - low);
+            loss_b = loss(data, weights, b, threads);
+        }
+    }
+    return (low + high) / 2;
+}
+
+void optimize(const Dataset &data, std::vector<double> &weights, double k, const Options &options,
+              const std::function<void(const EpochReport &)> &on_epoch) {
+    constexpr double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+    std::vector<double> gradient, first_moment(WEIGHT_COUNT, 0.0), second_moment(WEIGHT_COUNT, 0.0);
+
+    for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+        auto start = std::chrono::steady_clock::now();
+        double epoch_loss = mean_error(data, weights, k, options.threads, &gradient);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double correction1 = 1 - std::pow(BETA1, epoch);
+        double correction2 = 1 - std::pow(BETA2, epoch);
+        for (int i = 0; i < WEIGHT_COUNT; ++i) {
+            first_moment[i] = BETA1 * first_moment[i] + (1 - BETA1) * gradient[i];
+            second_moment[i] = BETA2 * second_moment[i] + (1 - BETA2) * gradient[i] * gradient[i];
+            weights[i] -= options.learning_rate * (first_moment[i] / correction1) / (std::sqrt(second_moment[i] / correction2) + EPSILON);
+        }
+
+        if (on_epoch) {
+            on_epoch({epoch, epoch_loss, data.positions.size() / std::max(elapsed.count(), 1e-9)});
+        }
+    }
+}
+
+std::string format_array(const std::vector<double> &weights, int offset, int count) {
+    std::string text = "{";
+    for (int i = 0; i < count; ++i) {
+        text += (i == 0 ? "" : ", ") + std::to_string(static_cast<int>(std::lround(weights[offset + i])));
+    }
+    return text;
+}
+
+std::string format_table(const char *name, const std::vector<double> &weights, int offset) {
+    std::string text = "constexpr std::array<int, 64> " + std::string(name) + " = {\n";
+    char cell[16];
+    for (int row = 0; row < 8; ++row) {
+        text += "   ";
+        for (int column = 0; column < 8; ++column) {
+            int sq = row * 8 + column;
+            std::snprintf(cell, sizeof(cell), " %4ld%s", std::lround(weights[offset + sq]), sq == 63 ? "" : ",");
+            text += cell;
+        }
+        text += "\n";
+    }
+    return text + "};\n";
+}
+
+std::string weights_header(const std::vector<double> &weights) {
+    std::string text =
+        "#ifndef CHESS_ENGINE_EVAL_WEIGHTS_H\n"
+        "#define CHESS_ENGINE_EVAL_WEIGHTS_H\n"
+        "\n"
+        "#include <array>\n"
+        "\n"
+        "namespace chess_engine {\n"
+        "namespace evaluate {\n"
+        "\n"
+        "// Weights of the hand-written evaluation, in centipawns. chess_tune regenerates this file from\n"
+        "// labeled positions; hand edits only seed the next tuning run.\n"
+        "//\n"
+        "// Piece-square tables are indexed by square (a1 = 0) for White and by the square mirrored\n"
+        "// vertically for Black.\n"
+        "\n";
+    text += "constexpr std::array<int, 6> material_value = " + format_array(weights, MATERIAL, 5) + ", 0};\n";
+    text += "constexpr std::array<int, 6> mg_value = " + format_array(weights, MG_VALUE, 5) + ", 0};\n";
+    text += "constexpr std::array<int, 6> eg_value = " + format_array(weights, EG_VALUE, 5) + ", 0};\n";
+    text += "\n// clang-format off\n";
+    for (const char *phase : {"mg", "eg"}) {
+        int offset = (phase[0] == 'm') ? MG_TABLE : EG_TABLE;
+        for (int type = 0; type < 6; ++type) {
+            std::string name = std::string(phase) + "_" + PIECE_NAMES[type] + "_table";
+            text += format_table(name.c_str(), weights, offset + 64 * type) + "\n";
+        }
+    }
+    for (const char *phase : {"mg", "eg"}) {
+        text += "constexpr std::array<std::array<int, 64>, 6> " + std::string(phase) + "_pesto_table = {\n";
+        for (int type = 0; type < 6; ++type) {
+            text += "    " + std::string(phase) + "_" + PIECE_NAMES[type] + "_table" + (type < 5 ? ",\n" : "\n");
+        }
+        text += (phase[0] == 'm') ? "};\n\n" : "};\n";
+    }
+    text += "// clang-format on\n\n";
+    text += "// Per file with more than one pawn\n";
+    text += "constexpr int doubled_pawn_penalty = " + std::to_string(std::lround(weights[DOUBLED])) + ";\n";
+    text += "// Per file whose pawns have no pawn on an adjacent file\n";
+    text += "constexpr int isolated_pawn_penalty = " + std::to_string(std::lround(weights[ISOLATED])) + ";\n";
+    text += "// Per pawn on the three squares in front of the king\n";
+    text += "constexpr int king_shield_bonus = " + std::to_string(std::lround(weights[SHIELD])) + ";\n";
+    text +=
+        "\n"
+        "} // namespace evaluate\n"
+        "} // namespace chess_engine\n"
+        "\n"
+        "#endif\n";
+    return text;
+}
+
+} // namespace tune
+} // namespace chess_engine
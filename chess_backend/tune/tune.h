@@ -0,0 +1,85 @@
+#ifndef CHESS_ENGINE_TUNE_H
+#define CHESS_ENGINE_TUNE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chess_engine {
+namespace tune {
+
+// The hand-written evaluation as a linear function of its weights. From White's side:
+//
+//   sum over pieces of  +-(material[type] + (mg value + mg table) * phase / 24
+//                                         + (eg value + eg table) * (24 - phase) / 24)
+//   - doubled * doubled files - isolated * isolated files + shield * shield pawns
+//
+// Weights are laid out as below; kings have no material weights since they always cancel.
+constexpr int MATERIAL = 0;         // [5] pawn to queen
+constexpr int MG_VALUE = 5;         // [5]
+constexpr int EG_VALUE = 10;        // [5]
+constexpr int MG_TABLE = 15;        // [6][64]
+constexpr int EG_TABLE = 15 + 384;  // [6][64]
+constexpr int DOUBLED = 15 + 768;   // Penalty, subtracted
+constexpr int ISOLATED = DOUBLED + 1;
+constexpr int SHIELD = DOUBLED + 2;
+constexpr int WEIGHT_COUNT = DOUBLED + 3;
+
+// A labeled position reduced to what the evaluation reads. Its pieces are packed as
+// (black << 9) | (type << 6) | square in Dataset::pieces, starting at first.
+struct Position {
+    uint32_t first;
+    uint8_t count;
+    uint8_t phase;  // evaluate::game_phase
+    uint8_t result; // White's score in half points: 0, 1 or 2
+    int8_t doubled_files;
+    int8_t isolated_files;
+    int8_t shield_pawns;
+};
+
+struct Dataset {
+    std::vector<Position> positions;
+    std::vector<uint16_t> pieces;
+    uint64_t skipped = 0; // Lines without a readable FEN or result
+};
+
+// Read EPD/FEN lines, each labeled with White's result as "1-0", "0-1" or "1/2-1/2" (quoted or
+// not) or as a score [1.0], [0.5] or [0.0], and datagen records from files named *.bin. The
+// positions are assumed quiet. Files are split across the threads; max_positions of 0 reads
+// everything.
+Dataset load(const std::vector<std::string> &paths, int threads, size_t max_positions = 0);
+
+// The weights evaluate.cpp is compiled with
+std::vector<double> current_weights();
+
+// Mean squared error between the results and the win probability 1 / (1 + 10^(-k * eval / 400))
+double loss(const Dataset &data, const std::vector<double> &weights, double k, int threads);
+
+// The k that makes the given weights fit the results best
+double find_k(const Dataset &data, const std::vector<double> &weights, int threads);
+
+struct Options {
+    int epochs = 500;
+    double learning_rate = 1.0; // Adam step, in centipawns
+    int threads = 1;
+};
+
+struct EpochReport {
+    int epoch;
+    double loss;                // Before this epoch's step
+    double positions_per_second; // Loss and gradient over the whole dataset
+};
+
+// Full-batch gradient descent (Adam) on the loss. on_epoch is called after every epoch.
+void optimize(const Dataset &data, std::vector<double> &weights, double k, const Options &options,
+              const std::function<void(const EpochReport &)> &on_epoch = nullptr);
+
+// eval_weights.h with the given weights, rounded to centipawns
+std::string weights_header(const std::vector<double> &weights);
+
+} // namespace tune
+} // namespace chess_engine
+
+#endif
@@ -0,0 +1,23 @@
+#include "../bench/bench.h"
+#include "../generator/zobrist.h"
+#include "uci.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace chess_engine;
+
+// Usage: chess_engine_uci [bench [depth]]
+int main(int argc, char **argv) {
+    // Initialize Zobrist keys
+    zobrist::init_zobrist_keys();
+
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        int depth = (argc > 2) ? std::atoi(argv[2]) : bench::DEFAULT_BENCH_DEPTH;
+        bench::run(depth, std::cout);
+        return 0;
+    }
+
+    uci::loop(std::cin, std::cout);
+    return 0;
+}
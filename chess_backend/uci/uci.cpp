@@ -0,0 +1,365 @@
+#include "uci.h"
+#include "../bench/bench.h"
+#include "../enums.h"
+#include "../generator/book.h"
+#include "../generator/evaluate.h"
+#include "../generator/nnue.h"
+#include "../generator/search.h"
+#include "../generator/tablebase.h"
+#include "../generator/transposition.h"
+#include "../moves/moves.h"
+#include "../structure/game_state.h"
+#include "../utils.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <new>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chess_engine {
+namespace uci {
+
+const int DEFAULT_HASH_MB = 64;
+const int MAX_HASH_MB = 65536;
+const int MAX_THREADS = 256;
+const int MAX_BOOK_PLY = 1000;
+
+// Never plan to use the last few milliseconds of the clock
+const int64_t MOVE_OVERHEAD_MS = 50;
+
+struct Engine {
+    std::ostream *out = nullptr;
+    std::mutex out_mutex;
+
+    game_state::GameState position = game_state::set_game_state(utils::START_FEN);
+    search::SearchState search_state; // Repetition keys and move-ordering tables of the current game
+    int multipv = 1;
+    bool own_book = false; // Play book moves without searching
+
+    std::thread search_thread;
+    std::unique_ptr<search::CancellationToken> token;
+
+    // A search started with "go infinite" or "go ponder" must not report its move
+    // before "stop" or "ponderhit", even if it finishes early
+    std::mutex hold_mutex;
+    std::condition_variable hold_released;
+    bool infinite = false;
+    bool pondering = false;
+    int64_t ponder_time_ms = 0; // Time to allot once a ponder search becomes a normal one
+};
+
+void send(Engine &engine, const std::string &line) {
+    std::lock_guard<std::mutex> lock(engine.out_mutex);
+    *engine.out << line << std::endl;
+}
+
+// Time to spend on this move: an even share of the clock plus most of the increment
+int64_t allocate_time(int64_t time_left, int64_t increment, int moves_to_go) {
+    int moves = (moves_to_go > 0) ? moves_to_go : 30;
+    int64_t budget = time_left / moves + increment * 3 / 4;
+    return std::max<int64_t>(1, std::min(budget, time_left - MOVE_OVERHEAD_MS));
+}
+
+// "cp <centipawns>", or "mate <moves>" with a negative count when getting mated
+std::string score_to_string(int score) {
+    if (evaluate::is_mate_score(score)) {
+        return "mate " + std::to_string(evaluate::mate_in_moves(score));
+    }
+    return "cp " + std::to_string(evaluate::to_centipawns(score));
+}
+
+std::string info_to_string(const search::SearchInfo &info) {
+    std::string line = "info depth " + std::to_string(info.depth) +
+                       " multipv " + std::to_string(info.multipv) +
+                       " score " + score_to_string(info.score) +
+                       " nodes " + std::to_string(info.nodes) +
+                       " nps " + std::to_string(info.nps) +
+                       " hashfull " + std::to_string(info.hashfull) +
+                       " tbhits " + std::to_string(info.tbhits) +
+                       " time " + std::to_string(info.time_ms);
+    if (!info.pv.empty()) {
+        line += " pv";
+        for (const auto &move : info.pv) {
+            line += " " + moves::to_uci(move);
+        }
+    }
+    return line;
+}
+
+void release_hold(Engine &engine) {
+    {
+        std::lock_guard<std::mutex> lock(engine.hold_mutex);
+        engine.infinite = false;
+        engine.pondering = false;
+    }
+    engine.hold_released.notify_all();
+}
+
+// Stop the running search, if any, and wait for it to report its move
+void stop_search(Engine &engine) {
+    if (!engine.search_thread.joinable()) {
+        return;
+    }
+    engine.token->cancel();
+    release_hold(engine);
+    engine.search_thread.join();
+}
+
+// position [startpos | fen <fen>] [moves <move>...]
+void handle_position(Engine &engine, std::istringstream &args) {
+    std::string token, fen;
+    args >> token;
+    if (token == "startpos") {
+        fen = utils::START_FEN;
+        args >> token; // "moves", if present
+    } else if (token == "fen") {
+        while (args >> token && token != "moves") {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+    } else {
+        return;
+    }
+
+    try {
+        engine.position = game_state::set_game_state(fen);
+    } catch (const std::exception &e) {
+        send(engine, "info string invalid fen (" + std::string(e.what()) + "): " + fen);
+        return;
+    }
+
+    // GUIs resend the whole game every move, so the key history is rebuilt from scratch
+    engine.search_state.key_history.clear();
+    while (args >> token) {
+        moves::Move move = moves::from_uci(token, engine.position);
+        engine.search_state.push_position(engine.position);
+        if (move.is_null() || !engine.position.make_move(move)) {
+            engine.search_state.key_history.pop_back();
+            send(engine, "info string illegal move: " + token);
+            break;
+        }
+    }
+}
+
+// go [ponder] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>]
+//    [depth <n>] [nodes <n>] [movetime <ms>] [infinite]
+void handle_go(Engine &engine, std::istringstream &args) {
+    search::SearchLimits limits;
+    limits.depth = search::MAX_DEPTH;
+    limits.multipv = engine.multipv;
+
+    int64_t time_left[2] = {0, 0};
+    int64_t increment[2] = {0, 0};
+    int moves_to_go = 0;
+    bool infinite = false;
+    bool ponder = false;
+
+    std::string token;
+    while (args >> token) {
+        if (token == "wtime") {
+            args >> time_left[piece::WHITE];
+        } else if (token == "btime") {
+            args >> time_left[piece::BLACK];
+        } else if (token == "winc") {
+            args >> increment[piece::WHITE];
+        } else if (token == "binc") {
+            args >> increment[piece::BLACK];
+        } else if (token == "movestogo") {
+            args >> moves_to_go;
+        } else if (token == "depth") {
+            args >> limits.depth;
+        } else if (token == "nodes") {
+            args >> limits.nodes;
+        } else if (token == "movetime") {
+            args >> limits.movetime_ms;
+        } else if (token == "infinite") {
+            infinite = true;
+        } else if (token == "ponder") {
+            ponder = true;
+        }
+    }
+
+    int64_t allotted_ms = 0;
+    piece::Color side = engine.position.turn;
+    if (time_left[side] > 0) {
+        allotted_ms = allocate_time(time_left[side], increment[side], moves_to_go);
+    }
+
+    engine.token = std::make_unique<search::CancellationToken>();
+    if (ponder) {
+        // The clock only starts on "ponderhit"; until then search without a deadline
+        engine.ponder_time_ms = std::max(allotted_ms, limits.movetime_ms);
+        limits.movetime_ms = 0;
+    } else if (allotted_ms > 0 && limits.movetime_ms == 0) {
+        limits.movetime_ms = allotted_ms;
+    }
+
+    engine.infinite = infinite;
+    engine.pondering = ponder;
+
+    // A book move needs no search, unless the GUI wants one that runs until stopped
+    moves::Move book_move;
+    if (engine.own_book && !infinite && !ponder && limits.multipv <= 1 && book::probe(engine.position, book_move)) {
+        send(engine, "bestmove " + moves::to_uci(book_move));
+        return;
+    }
+
+    game_state::GameState position = engine.position;
+    engine.search_thread = std::thread([&engine, limits, position]() mutable {
+        std::vector<moves::Move> last_pv;
+        moves::Move best_move = search::find_best_move(limits, position.turn, position, [&](const search::SearchInfo &info) {
+            if (info.multipv == 1) {
+                last_pv = info.pv;
+            }
+            send(engine, info_to_string(info));
+        }, engine.token.get(), &engine.search_state);
+
+        {
+            std::unique_lock<std::mutex> lock(engine.hold_mutex);
+            engine.hold_released.wait(lock, [&engine]() { return !engine.infinite && !engine.pondering; });
+        }
+
+        std::string line = "bestmove " + moves::to_uci(best_move);
+        if (last_pv.size() >= 2 && last_pv[0] == best_move) {
+            line += " ponder " + moves::to_uci(last_pv[1]);
+        }
+        send(engine, line);
+    });
+}
+
+// The opponent played the move we pondered on: keep the tree and start the clock
+void handle_ponderhit(Engine &engine) {
+    if (!engine.search_thread.joinable()) {
+        return;
+    }
+    if (engine.ponder_time_ms > 0) {
+        engine.token->set_deadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(engine.ponder_time_ms));
+    }
+    {
+        std::lock_guard<std::mutex> lock(engine.hold_mutex);
+        engine.pondering = false;
+    }
+    engine.hold_released.notify_all();
+}
+
+// setoption name <name> [value <value>]
+void handle_setoption(Engine &engine, std::istringstream &args) {
+    std::string token, name, value;
+    args >> token; // "name"
+    while (args >> token && token != "value") {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    std::getline(args >> std::ws, value); // Paths may contain spaces
+
+    try {
+        if (name == "Hash") {
+            int size_mb = std::clamp(std::stoi(value), 1, MAX_HASH_MB);
+            search::resize_tt(size_mb);
+        } else if (name == "Threads") {
+            search::thread_count = std::clamp(std::stoi(value), 1, MAX_THREADS);
+            search::tt.set_init_threads(search::thread_count);
+        } else if (name == "MultiPV") {
+            engine.multipv = std::clamp(std::stoi(value), 1, search::MAX_MULTIPV);
+        } else if (name == "Clear Hash") {
+            search::clear_tt();
+        } else if (name == "SyzygyPath") {
+            if (tablebase::init(value == "<empty>" ? "" : value)) {
+                send(engine, "info string found tablebases up to " + std::to_string(tablebase::max_pieces()) + " pieces");
+            } else if (value != "<empty>" && !value.empty()) {
+                send(engine, "info string no tablebases found in " + value);
+            }
+        } else if (name == "OwnBook") {
+            engine.own_book = value == "true";
+        } else if (name == "BookFile") {
+            if (book::open(value == "<empty>" ? "" : value)) {
+                send(engine, "info string book with " + std::to_string(book::size()) + " entries");
+            } else if (value != "<empty>" && !value.empty()) {
+                send(engine, "info string cannot open book " + value);
+            }
+        } else if (name == "BookDepth") {
+            book::set_max_ply(std::clamp(std::stoi(value), 0, MAX_BOOK_PLY));
+        } else if (name == "EvalFile") {
+            if (nnue::load(value)) {
+                send(engine, std::string("info string NNUE network loaded (") + nnue::simd_name() + ")");
+            } else if (value != "<empty>" && !value.empty()) {
+                send(engine, "info string cannot load NNUE network " + value);
+            }
+        } else if (name == "Use NNUE") {
+            nnue::set_enabled(value == "true");
+        } else if (name != "Ponder") {
+            send(engine, "info string unknown option: " + name);
+        }
+    } catch (const std::bad_alloc &) {
+        send(engine, "info string cannot allocate " + value + " MB, hash size unchanged");
+    } catch (const std::exception &e) {
+        send(engine, "info string invalid value for " + name + ": " + value);
+    }
+}
+
+void loop(std::istream &in, std::ostream &out) {
+    Engine engine;
+    engine.out = &out;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream args(line);
+        std::string command;
+        args >> command;
+
+        if (command == "uci") {
+            send(engine, "id name ChessEngine");
+            send(engine, "id author Lucas Coelho");
+            send(engine, "option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) + " min 1 max " + std::to_string(MAX_HASH_MB));
+            send(engine, "option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+            send(engine, "option name MultiPV type spin default 1 min 1 max " + std::to_string(search::MAX_MULTIPV));
+            send(engine, "option name Clear Hash type button");
+            send(engine, "option name Ponder type check default false");
+            send(engine, "option name SyzygyPath type string default <empty>");
+            send(engine, "option name OwnBook type check default false");
+            send(engine, "option name BookFile type string default <empty>");
+            send(engine, "option name BookDepth type spin default " + std::to_string(book::DEFAULT_MAX_PLY) + " min 0 max " + std::to_string(MAX_BOOK_PLY));
+            send(engine, "option name EvalFile type string default <empty>");
+            send(engine, "option name Use NNUE type check default true");
+            send(engine, "uciok");
+        } else if (command == "isready") {
+            send(engine, "readyok");
+        } else if (command == "ucinewgame") {
+            stop_search(engine);
+            search::clear_tt();
+            engine.search_state = search::SearchState();
+        } else if (command == "position") {
+            stop_search(engine);
+            handle_position(engine, args);
+        } else if (command == "go") {
+            stop_search(engine);
+            handle_go(engine, args);
+        } else if (command == "stop") {
+            stop_search(engine);
+        } else if (command == "ponderhit") {
+            handle_ponderhit(engine);
+        } else if (command == "setoption") {
+            stop_search(engine);
+            handle_setoption(engine, args);
+        } else if (command == "bench") {
+            stop_search(engine);
+            int depth = bench::DEFAULT_BENCH_DEPTH;
+            args >> depth;
+            bench::run(depth, out);
+        } else if (command == "d") {
+            send(engine, engine.position.get_board().to_string());
+        } else if (command == "quit") {
+            break;
+        } else if (!command.empty()) {
+            send(engine, "info string unknown command: " + command);
+        }
+    }
+
+    stop_search(engine);
+}
+
+} // namespace uci
+} // namespace chess_engine
@@ -0,0 +1,17 @@
+#ifndef CHESS_ENGINE_UCI_H
+#define CHESS_ENGINE_UCI_H
+
+#include <istream>
+#include <ostream>
+
+namespace chess_engine {
+namespace uci {
+
+// Run the Universal Chess Interface protocol until "quit" or end of input.
+// Position, transposition table and options persist between commands.
+void loop(std::istream &in, std::ostream &out);
+
+} // namespace uci
+} // namespace chess_engine
+
+#endif
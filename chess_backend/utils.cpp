@@ -2,9 +2,16 @@
 #include "structure/bitboard.h"
 #include "structure/board.h"
 #include "structure/square.h"
+#include <algorithm>
 #include <array>
+#include <cctype>
 #include <cstdint>
+#include <fcntl.h>
 #include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 
 namespace utils {
@@ -66,4 +73,46 @@ std::string piece_color_to_string(piece::Color color) {
     return (color == piece::Color::WHITE) ? "White" : "Black";
 }
 
+std::string trim(const std::string &text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+bool is_number(const std::string &text) {
+    return !text.empty() && std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); });
+}
+
+MappedFile::MappedFile(const std::string &path, Access access) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    size_ = info.st_size;
+    if (size_ > 0) {
+        void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("cannot map " + path);
+        }
+        madvise(data, size_, access == Access::RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(data);
+    }
+    ::close(fd); // The mapping keeps the file open
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char *>(data_), size_);
+    }
+}
+
 } // namespace utils
\ No newline at end of file
@@ -8,8 +8,10 @@
 #include "structure/square.h"
 #include "utils.h"
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <string>
 #include <vector>
 
 namespace utils {
@@ -26,5 +28,41 @@ std::string piece_type_to_string(piece::Type type);
 
 std::string piece_color_to_string(piece::Color color);
 
+inline const std::string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Text without leading and trailing spaces, tabs and carriage returns
+std::string trim(const std::string &text);
+
+// True for a non-empty string of decimal digits
+bool is_number(const std::string &text);
+
+// A whole file mapped read-only. Throws std::runtime_error if it cannot be opened or mapped;
+// an empty file maps to a null data() of size 0.
+class MappedFile {
+  public:
+    enum class Access {
+        SEQUENTIAL, // Read once front to back: the kernel reads ahead and drops pages behind
+        RANDOM      // Scattered probes: pages are faulted in one at a time
+    };
+
+    explicit MappedFile(const std::string &path, Access access = Access::SEQUENTIAL);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+  private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
 } // namespace utils
 #endif
\ No newline at end of file